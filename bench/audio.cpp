@@ -0,0 +1,386 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+// Headless audio benchmarks, meant to run with SDL_AUDIODRIVER=dummy or disk.
+//
+// Every result is printed as one JSON object per line:
+// {"suite":"convert","case":"S16_F32","samples":1024,"driver":"dummy","metric":"ns_per_frame","value":1.5}
+//
+// usage: sdlwrapper-bench [--quick] [--output FILE]
+
+#include "sdlwrapper/adpcm.hpp"
+#include "sdlwrapper/audio.hpp"
+#include "sdlwrapper/audio_convert.hpp"
+#include "sdlwrapper/audio_instrumentation.hpp"
+#include "sdlwrapper/mixer.hpp"
+#include "sdlwrapper/offline_renderer.hpp"
+#include "sdlwrapper/resampler.hpp"
+#include "sdlwrapper/sdl.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+using sdlwrapper::Sdl;
+using sdlwrapper::AdpcmReader;
+using sdlwrapper::AdpcmSamples;
+using sdlwrapper::SubsystemType;
+using sdlwrapper::AudioDevice;
+using sdlwrapper::AudioCallbackStats;
+using sdlwrapper::AudioFormat;
+using sdlwrapper::Mixer;
+using sdlwrapper::OfflineRenderer;
+using sdlwrapper::Resampler;
+using sdlwrapper::ResamplerQuality;
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int FREQ = 48000;
+constexpr std::uint8_t CHANNELS = 2;
+constexpr std::uint16_t BUFFER_SAMPLES[] = {256, 512, 1024, 2048, 4096, 8192};
+
+struct Options
+{
+    bool quick = false;
+    std::FILE* output = stdout;
+    const char* driver = "";
+};
+
+Options options;
+
+void report(const char* suite, const char* name, int samples, const char* metric, double value)
+{
+    std::fprintf(options.output, "{\"suite\":\"%s\",\"case\":\"%s\",\"samples\":%d,\"driver\":\"%s\",\"metric\":\"%s\",\"value\":%.6g}\n",
+                 suite, name, samples, options.driver, metric, value);
+}
+
+double elapsedNanoseconds(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+// average nanoseconds per call of f, after one warm up call
+template <typename F>
+double measure(F f)
+{
+    f();
+    double minNanoseconds = options.quick ? 2e6 : 50e6;
+    std::size_t calls = 0;
+    Clock::time_point start = Clock::now();
+    double elapsed;
+    do {
+        f();
+        ++calls;
+    } while((elapsed = elapsedNanoseconds(start)) < minNanoseconds);
+    return elapsed / calls;
+}
+
+std::vector<float> makeNoise(std::size_t count)
+{
+    std::mt19937 random {1234};
+    std::uniform_real_distribution<float> distribution {-0.5f, 0.5f};
+    std::vector<float> noise(count);
+    for(float& sample : noise) {
+        sample = distribution(random);
+    }
+    return noise;
+}
+
+void benchConvert(int samples)
+{
+    struct Case
+    {
+        const char* name;
+        AudioFormat src;
+        AudioFormat dst;
+    };
+    const Case cases[] = {
+        {"S16_F32", AUDIO_S16SYS, AUDIO_F32SYS},
+        {"F32_S16", AUDIO_F32SYS, AUDIO_S16SYS},
+        {"S32_F32", AUDIO_S32SYS, AUDIO_F32SYS},
+        {"U8_F32", AUDIO_U8, AUDIO_F32SYS},
+        {"S16MSB_S16LSB", AUDIO_S16MSB, AUDIO_S16LSB},
+    };
+
+    std::size_t count = static_cast<std::size_t>(samples) * CHANNELS;
+    std::vector<std::uint8_t> src(count * 4);
+    std::vector<std::uint8_t> dst(count * 4);
+    std::vector<float> noise = makeNoise(count);
+    sdlwrapper::convert(AUDIO_F32SYS, AUDIO_S32SYS, noise.data(), src.data(), count);
+
+    for(const Case& c : cases) {
+        double ns = measure([&] {
+            sdlwrapper::convert(c.src, c.dst, src.data(), dst.data(), count);
+        });
+        report("convert", c.name, samples, "ns_per_frame", ns / samples);
+
+        // SDL converts in place, in a buffer len_mult times the source length
+        SDL_AudioCVT cvt;
+        if(SDL_BuildAudioCVT(&cvt, c.src, CHANNELS, FREQ, c.dst, CHANNELS, FREQ) < 0) {
+            continue;
+        }
+        int srcLen = static_cast<int>(count * SDL_AUDIO_BITSIZE(c.src) / 8);
+        std::vector<std::uint8_t> buffer(static_cast<std::size_t>(srcLen) * cvt.len_mult);
+        cvt.buf = buffer.data();
+        cvt.len = srcLen;
+        ns = measure([&] {
+            std::memcpy(buffer.data(), src.data(), static_cast<std::size_t>(srcLen));
+            SDL_ConvertAudio(&cvt);
+        });
+        report("convert_sdl", c.name, samples, "ns_per_frame", ns / samples);
+    }
+}
+
+void benchMix(int samples)
+{
+    const std::size_t voiceCounts[] = {1, 8, 64, 256};
+    std::vector<float> mono = makeNoise(FREQ);
+    std::vector<float> stereo = makeNoise(FREQ * 2);
+    std::vector<float> out(static_cast<std::size_t>(samples) * CHANNELS);
+
+    for(std::size_t voices : voiceCounts) {
+        Mixer mixer {voices};
+        for(std::size_t i = 0; i < voices; ++i) {
+            if(i % 2 == 0) {
+                mixer.play(mono.data(), FREQ, 1, 0.1f, 0.5f, true);
+            }
+            else {
+                mixer.play(stereo.data(), FREQ, 2, 0.1f, 0.0f, true);
+            }
+        }
+        double ns = measure([&] {
+            mixer.mix(out.data(), static_cast<std::size_t>(samples));
+        });
+        char name[32];
+        std::snprintf(name, sizeof(name), "voices_%zu", voices);
+        report("mix", name, samples, "ns_per_frame", ns / samples);
+    }
+}
+
+void benchAdpcm(int samples)
+{
+    std::vector<float> noise = makeNoise(static_cast<std::size_t>(FREQ) * CHANNELS);
+    std::vector<std::int16_t> frames(noise.size());
+    sdlwrapper::convert<AUDIO_F32SYS, AUDIO_S16SYS>(noise.data(), frames.data(), frames.size());
+
+    AdpcmSamples compressed {frames.data(), FREQ, FREQ, CHANNELS};
+    AdpcmReader reader {compressed, true};
+    std::vector<float> out(static_cast<std::size_t>(samples) * CHANNELS);
+
+    double ns = measure([&] {
+        reader.read(out.data(), static_cast<std::uint32_t>(samples));
+    });
+    report("adpcm", "decode", samples, "ns_per_frame", ns / samples);
+    report("adpcm", "decode", samples, "compression_ratio", static_cast<double>(noise.size() * sizeof(float)) / compressed.getSizeBytes());
+}
+
+void benchResample(int samples)
+{
+    struct Case
+    {
+        const char* name;
+        int srcFreq;
+        int dstFreq;
+    };
+    const Case cases[] = {
+        {"44100_48000", 44100, 48000},
+        {"96000_48000", 96000, 48000},
+    };
+    struct Quality
+    {
+        const char* name;
+        ResamplerQuality quality;
+    };
+    const Quality qualities[] = {
+        {"linear", ResamplerQuality::LINEAR},
+        {"sinc_medium", ResamplerQuality::SINC_MEDIUM},
+        {"sinc_high", ResamplerQuality::SINC_HIGH},
+    };
+
+    std::vector<float> out(static_cast<std::size_t>(samples) * CHANNELS);
+    for(const Case& c : cases) {
+        std::size_t inFrames = static_cast<std::size_t>(samples) * c.srcFreq / c.dstFreq + 1;
+        std::vector<float> in = makeNoise(inFrames * CHANNELS);
+        for(const Quality& q : qualities) {
+            Resampler resampler {c.srcFreq, c.dstFreq, CHANNELS, q.quality};
+            // frames produced, since the output count varies by a frame per call
+            std::size_t produced = 0;
+            std::size_t calls = 0;
+            double ns = measure([&] {
+                produced += resampler.process(in.data(), inFrames, out.data(), out.size() / CHANNELS).outputFrames;
+                ++calls;
+            });
+            char name[64];
+            std::snprintf(name, sizeof(name), "%s_%s", c.name, q.name);
+            report("resample", name, samples, "ns_per_frame", ns * calls / static_cast<double>(produced));
+        }
+    }
+}
+
+void benchCallback(const sdlwrapper::AudioSubsystem& audio, int samples)
+{
+    std::vector<float> mono = makeNoise(FREQ);
+    Mixer mixer {64};
+    for(int i = 0; i < 64; ++i) {
+        mixer.play(mono.data(), FREQ, 1, 0.01f, 0.0f, true);
+    }
+
+    AudioDevice device {audio, nullptr, false, FREQ, AUDIO_F32SYS, CHANNELS, static_cast<std::uint16_t>(samples), Mixer::callback, &mixer};
+    const SDL_AudioSpec& spec = device.getObtainedSpec();
+
+    // long enough for several callbacks at the largest buffer size
+    int callbacks = options.quick ? 3 : 20;
+    std::uint32_t durationMs = static_cast<std::uint32_t>(std::uint64_t{spec.samples} * 1000 * callbacks / spec.freq) + 10;
+
+    Clock::time_point start = Clock::now();
+    device.play();
+    SDL_Delay(durationMs);
+    device.pause();
+    double seconds = elapsedNanoseconds(start) * 1e-9;
+
+    AudioCallbackStats::Snapshot stats = device.getCallbackStats().getSnapshot();
+    report("callback", "mixer_64_voices", samples, "callbacks_per_sec", stats.callbacks / seconds);
+    report("callback", "mixer_64_voices", samples, "frames_per_sec", stats.callbacks * spec.samples / seconds);
+    report("callback", "mixer_64_voices", samples, "duration_p50_us", stats.durations.getPercentile(0.5));
+    report("callback", "mixer_64_voices", samples, "duration_p99_us", stats.durations.getPercentile(0.99));
+    report("callback", "mixer_64_voices", samples, "duration_max_us", stats.durations.max);
+    report("callback", "mixer_64_voices", samples, "interval_p99_us", stats.intervals.getPercentile(0.99));
+    report("callback", "mixer_64_voices", samples, "deadline_us", stats.deadline);
+    report("callback", "mixer_64_voices", samples, "missed_deadlines", stats.missedDeadlines);
+}
+
+void benchOffline(int samples)
+{
+    constexpr std::size_t TRACKS = 16;
+    std::vector<float> mono = makeNoise(FREQ);
+    std::size_t frames = static_cast<std::size_t>(FREQ) * (options.quick ? 10 : 60);
+    std::vector<float> out(frames * CHANNELS);
+
+    SDL_AudioSpec spec {};
+    spec.freq = FREQ;
+    spec.format = AUDIO_F32SYS;
+    spec.channels = CHANNELS;
+    spec.samples = static_cast<std::uint16_t>(samples);
+
+    // one worker, then one per core
+    for(std::size_t threads : {std::size_t{1}, std::size_t{0}}) {
+        OfflineRenderer renderer {spec, threads};
+        std::vector<std::unique_ptr<Mixer>> mixers;
+        for(std::size_t i = 0; i < TRACKS; ++i) {
+            mixers.push_back(std::make_unique<Mixer>(16));
+            for(int voice = 0; voice < 16; ++voice) {
+                mixers.back()->play(mono.data(), FREQ, 1, 0.01f, 0.0f, true);
+            }
+            renderer.addTrack(Mixer::callback, mixers.back().get());
+        }
+
+        Clock::time_point start = Clock::now();
+        renderer.render(out.data(), frames);
+        double seconds = elapsedNanoseconds(start) * 1e-9;
+
+        char name[32];
+        std::snprintf(name, sizeof(name), "threads_%zu", renderer.getThreads());
+        report("offline", name, samples, "realtime_factor", frames / static_cast<double>(FREQ) / seconds);
+    }
+}
+
+#ifdef SDLWRAPPER_AUDIO_SUPPORTS_NONCALLBACK
+void benchQueue(const sdlwrapper::AudioSubsystem& audio, int samples)
+{
+    AudioDevice device {audio, nullptr, false, FREQ, AUDIO_F32SYS, CHANNELS, static_cast<std::uint16_t>(samples)};
+    const SDL_AudioSpec& spec = device.getObtainedSpec();
+    std::vector<std::uint8_t> buffer(spec.size, 0);
+    device.play();
+
+    // time from queueing one buffer on an empty queue until the device has taken all of it
+    int iterations = options.quick ? 3 : 20;
+    std::vector<double> latencies;
+    for(int i = 0; i < iterations; ++i) {
+        Clock::time_point start = Clock::now();
+        device.queue(buffer.data(), spec.size);
+        while(device.getQueueSize() > 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        latencies.push_back(elapsedNanoseconds(start) * 1e-3);
+    }
+    device.pause();
+
+    std::sort(latencies.begin(), latencies.end());
+    report("queue", "single_buffer", samples, "latency_p50_us", latencies[latencies.size() / 2]);
+    report("queue", "single_buffer", samples, "latency_max_us", latencies.back());
+    report("queue", "single_buffer", samples, "buffer_us", spec.samples * 1e6 / spec.freq);
+}
+#endif // SDLWRAPPER_AUDIO_SUPPORTS_NONCALLBACK
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    for(int i = 1; i < argc; ++i) {
+        if(std::strcmp(argv[i], "--quick") == 0) {
+            options.quick = true;
+        }
+        else if(std::strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            options.output = std::fopen(argv[++i], "w");
+            if(options.output == nullptr) {
+                std::fprintf(stderr, "Couldn't open %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else {
+            std::fprintf(stderr, "usage: %s [--quick] [--output FILE]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // never play through real hardware unless asked to
+    SDL_setenv("SDL_AUDIODRIVER", "dummy", 0);
+
+    try {
+        Sdl<SubsystemType::AUDIO> sdl;
+        options.driver = SDL_GetCurrentAudioDriver();
+
+        for(int samples : BUFFER_SAMPLES) {
+            benchConvert(samples);
+            benchMix(samples);
+            benchAdpcm(samples);
+            benchResample(samples);
+            benchCallback(sdl.audio(), samples);
+            benchOffline(samples);
+#ifdef SDLWRAPPER_AUDIO_SUPPORTS_NONCALLBACK
+            benchQueue(sdl.audio(), samples);
+#endif // SDLWRAPPER_AUDIO_SUPPORTS_NONCALLBACK
+        }
+    }
+    catch(const sdlwrapper::SdlError& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    if(options.output != stdout) {
+        std::fclose(options.output);
+    }
+    return 0;
+}
@@ -16,10 +16,30 @@
 #ifndef SDLWRAPPER_HPP
 #define SDLWRAPPER_HPP
 
+#include "sdlwrapper/adpcm.hpp"
 #include "sdlwrapper/audio.hpp"
+#include "sdlwrapper/audio_arena.hpp"
+#include "sdlwrapper/audio_calibration.hpp"
+#include "sdlwrapper/audio_clock.hpp"
+#include "sdlwrapper/audio_convert.hpp"
+#include "sdlwrapper/audio_instrumentation.hpp"
+#include "sdlwrapper/audio_rt_check.hpp"
+#include "sdlwrapper/axis_processor.hpp"
+#include "sdlwrapper/capture_pipeline.hpp"
+#include "sdlwrapper/effect_graph.hpp"
+#include "sdlwrapper/event_pump.hpp"
 #include "sdlwrapper/game_controller.hpp"
+#include "sdlwrapper/game_controller_manager.hpp"
 #include "sdlwrapper/gl_context.hpp"
+#include "sdlwrapper/input_recording.hpp"
+#include "sdlwrapper/mixer.hpp"
+#include "sdlwrapper/offline_renderer.hpp"
+#include "sdlwrapper/queue_streamer.hpp"
+#include "sdlwrapper/resampler.hpp"
 #include "sdlwrapper/sdl.hpp"
+#include "sdlwrapper/wav_cache.hpp"
+#include "sdlwrapper/wav_loader.hpp"
+#include "sdlwrapper/wav_stream.hpp"
 #include "sdlwrapper/window.hpp"
 
 #endif // SDLWRAPPER_HPP
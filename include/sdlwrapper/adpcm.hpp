@@ -0,0 +1,500 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef SDLWRAPPER_ADPCM_HPP
+#define SDLWRAPPER_ADPCM_HPP
+
+#include "sdlwrapper/audio.hpp"
+#include "sdlwrapper/audio_convert.hpp"
+#include "sdlwrapper/detail/simd.hpp"
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace sdlwrapper
+{
+
+namespace detail
+{
+
+// IMA ADPCM quantizer steps
+inline constexpr std::int16_t ADPCM_STEPS[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+
+// step index change for each nibble magnitude
+inline constexpr std::int8_t ADPCM_INDEX_CHANGES[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+// every block splits each channel into this many sub-blocks, decoded side by side in SIMD lanes
+inline constexpr std::uint32_t ADPCM_LANES = 4;
+inline constexpr std::uint32_t ADPCM_LANE_FRAMES = 128;
+
+// per channel, per block: a 4 byte header per lane, then one 16 bit word per lane frame holding a nibble per lane
+inline constexpr std::size_t ADPCM_CHANNEL_BLOCK_BYTES = ADPCM_LANES * 4 + ADPCM_LANE_FRAMES * 2;
+
+struct AdpcmState
+{
+    std::int32_t predictor;
+    std::int32_t index;
+};
+
+inline void decodeAdpcmNibble(AdpcmState& state, std::uint32_t nibble)
+{
+    std::int32_t step = ADPCM_STEPS[state.index];
+    std::int32_t diff = step >> 3;
+    if(nibble & 4) {
+        diff += step;
+    }
+    if(nibble & 2) {
+        diff += step >> 1;
+    }
+    if(nibble & 1) {
+        diff += step >> 2;
+    }
+    state.predictor += (nibble & 8) ? -diff : diff;
+    state.predictor = std::min(std::max(state.predictor, -32768), 32767);
+    state.index = std::min(std::max(state.index + ADPCM_INDEX_CHANGES[nibble & 7], 0), 88);
+}
+
+inline std::uint32_t encodeAdpcmNibble(AdpcmState& state, std::int32_t sample)
+{
+    std::int32_t diff = sample - state.predictor;
+    std::uint32_t nibble = 0;
+    if(diff < 0) {
+        nibble = 8;
+        diff = -diff;
+    }
+    std::int32_t step = ADPCM_STEPS[state.index];
+    if(diff >= step) {
+        nibble |= 4;
+        diff -= step;
+    }
+    step >>= 1;
+    if(diff >= step) {
+        nibble |= 2;
+        diff -= step;
+    }
+    step >>= 1;
+    if(diff >= step) {
+        nibble |= 1;
+    }
+    // track the decoder, so errors don't accumulate
+    decodeAdpcmNibble(state, nibble);
+    return nibble;
+}
+
+// decode one channel of one block into interleaved float samples
+inline void decodeAdpcmChannel(const std::uint8_t* src, float* out, std::uint8_t channels)
+{
+    std::int32_t predictors[ADPCM_LANES];
+    std::int32_t indices[ADPCM_LANES];
+    for(std::uint32_t lane = 0; lane < ADPCM_LANES; ++lane) {
+        std::int16_t predictor;
+        std::memcpy(&predictor, src + lane * 4, sizeof(predictor));
+        predictors[lane] = predictor;
+        indices[lane] = src[lane * 4 + 2];
+    }
+    const std::uint8_t* words = src + ADPCM_LANES * 4;
+    const std::size_t laneStride = std::size_t{ADPCM_LANE_FRAMES} * channels;
+
+#if defined(SDLWRAPPER_SIMD_SSE2)
+    // lane k's nibble is bits 4k to 4k+3, shifted to the top of each 16 bit lane by a multiply
+    const __m128i laneShifts = _mm_set_epi16(0, 0, 0, 0, 1, 16, 256, 4096);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i two = _mm_set1_epi32(2);
+    const __m128i three = _mm_set1_epi32(3);
+    const __m128i four = _mm_set1_epi32(4);
+    const __m128i six = _mm_set1_epi32(6);
+    const __m128i seven = _mm_set1_epi32(7);
+    const __m128i eight = _mm_set1_epi32(8);
+    const __m128i maxIndex = _mm_set1_epi32(88);
+    const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+
+    __m128i predictor = _mm_loadu_si128(reinterpret_cast<const __m128i*>(predictors));
+    __m128i index = _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices));
+    alignas(16) std::int32_t lanes[ADPCM_LANES];
+    alignas(16) float samples[ADPCM_LANES];
+
+    for(std::uint32_t i = 0; i < ADPCM_LANE_FRAMES; ++i) {
+        std::uint16_t word;
+        std::memcpy(&word, words + i * 2, sizeof(word));
+        __m128i nibble = _mm_unpacklo_epi16(_mm_srli_epi16(_mm_mullo_epi16(_mm_set1_epi16(static_cast<short>(word)), laneShifts), 12), zero);
+
+        // SSE2 has no gather
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), index);
+        __m128i step = _mm_set_epi32(ADPCM_STEPS[lanes[3]], ADPCM_STEPS[lanes[2]], ADPCM_STEPS[lanes[1]], ADPCM_STEPS[lanes[0]]);
+
+        __m128i diff = _mm_srai_epi32(step, 3);
+        diff = _mm_add_epi32(diff, _mm_and_si128(_mm_cmpeq_epi32(_mm_and_si128(nibble, four), four), step));
+        diff = _mm_add_epi32(diff, _mm_and_si128(_mm_cmpeq_epi32(_mm_and_si128(nibble, two), two), _mm_srai_epi32(step, 1)));
+        diff = _mm_add_epi32(diff, _mm_and_si128(_mm_cmpeq_epi32(_mm_and_si128(nibble, one), one), _mm_srai_epi32(step, 2)));
+        __m128i negative = _mm_cmpeq_epi32(_mm_and_si128(nibble, eight), eight);
+        diff = _mm_sub_epi32(_mm_xor_si128(diff, negative), negative);
+
+        // saturate to 16 bits, and sign extend back
+        __m128i packed = _mm_packs_epi32(_mm_add_epi32(predictor, diff), zero);
+        predictor = _mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16);
+
+        // magnitudes below 4 step down by 1, the rest step up by 2 * (magnitude - 3)
+        __m128i magnitude = _mm_and_si128(nibble, seven);
+        __m128i up = _mm_cmpgt_epi32(magnitude, three);
+        __m128i change = _mm_or_si128(_mm_and_si128(up, _mm_sub_epi32(_mm_add_epi32(magnitude, magnitude), six)), _mm_andnot_si128(up, _mm_set1_epi32(-1)));
+        // indices stay within [-1, 96], where 16 bit min and max give the 32 bit result
+        index = _mm_min_epi16(_mm_max_epi16(_mm_add_epi32(index, change), zero), maxIndex);
+
+        _mm_store_ps(samples, _mm_mul_ps(_mm_cvtepi32_ps(predictor), scale));
+        for(std::uint32_t lane = 0; lane < ADPCM_LANES; ++lane) {
+            out[lane * laneStride + i * channels] = samples[lane];
+        }
+    }
+#elif defined(SDLWRAPPER_SIMD_NEON)
+    const std::int32_t shiftValues[ADPCM_LANES] = {0, -4, -8, -12};
+    const int32x4_t laneShifts = vld1q_s32(shiftValues);
+    const uint32x4_t nibbleMask = vdupq_n_u32(15);
+    const int32x4_t one = vdupq_n_s32(1);
+    const int32x4_t two = vdupq_n_s32(2);
+    const int32x4_t three = vdupq_n_s32(3);
+    const int32x4_t four = vdupq_n_s32(4);
+    const int32x4_t six = vdupq_n_s32(6);
+    const int32x4_t seven = vdupq_n_s32(7);
+    const int32x4_t eight = vdupq_n_s32(8);
+    const float32x4_t scale = vdupq_n_f32(1.0f / 32768.0f);
+
+    int32x4_t predictor = vld1q_s32(predictors);
+    int32x4_t index = vld1q_s32(indices);
+    std::int32_t lanes[ADPCM_LANES];
+    float samples[ADPCM_LANES];
+
+    for(std::uint32_t i = 0; i < ADPCM_LANE_FRAMES; ++i) {
+        std::uint16_t word;
+        std::memcpy(&word, words + i * 2, sizeof(word));
+        int32x4_t nibble = vreinterpretq_s32_u32(vandq_u32(vshlq_u32(vdupq_n_u32(word), laneShifts), nibbleMask));
+
+        // NEON has no gather
+        vst1q_s32(lanes, index);
+        const std::int32_t stepValues[ADPCM_LANES] = {ADPCM_STEPS[lanes[0]], ADPCM_STEPS[lanes[1]], ADPCM_STEPS[lanes[2]], ADPCM_STEPS[lanes[3]]};
+        int32x4_t step = vld1q_s32(stepValues);
+
+        int32x4_t diff = vshrq_n_s32(step, 3);
+        diff = vaddq_s32(diff, vandq_s32(vreinterpretq_s32_u32(vtstq_s32(nibble, four)), step));
+        diff = vaddq_s32(diff, vandq_s32(vreinterpretq_s32_u32(vtstq_s32(nibble, two)), vshrq_n_s32(step, 1)));
+        diff = vaddq_s32(diff, vandq_s32(vreinterpretq_s32_u32(vtstq_s32(nibble, one)), vshrq_n_s32(step, 2)));
+        int32x4_t negative = vreinterpretq_s32_u32(vtstq_s32(nibble, eight));
+        diff = vsubq_s32(veorq_s32(diff, negative), negative);
+
+        predictor = vmaxq_s32(vminq_s32(vaddq_s32(predictor, diff), vdupq_n_s32(32767)), vdupq_n_s32(-32768));
+
+        int32x4_t magnitude = vandq_s32(nibble, seven);
+        int32x4_t change = vbslq_s32(vcgtq_s32(magnitude, three), vsubq_s32(vaddq_s32(magnitude, magnitude), six), vdupq_n_s32(-1));
+        index = vmaxq_s32(vminq_s32(vaddq_s32(index, change), vdupq_n_s32(88)), vdupq_n_s32(0));
+
+        vst1q_f32(samples, vmulq_f32(vcvtq_f32_s32(predictor), scale));
+        for(std::uint32_t lane = 0; lane < ADPCM_LANES; ++lane) {
+            out[lane * laneStride + i * channels] = samples[lane];
+        }
+    }
+#else
+    AdpcmState states[ADPCM_LANES];
+    for(std::uint32_t lane = 0; lane < ADPCM_LANES; ++lane) {
+        states[lane] = {predictors[lane], indices[lane]};
+    }
+    for(std::uint32_t i = 0; i < ADPCM_LANE_FRAMES; ++i) {
+        std::uint16_t word;
+        std::memcpy(&word, words + i * 2, sizeof(word));
+        for(std::uint32_t lane = 0; lane < ADPCM_LANES; ++lane) {
+            decodeAdpcmNibble(states[lane], (word >> (lane * 4)) & 15);
+            out[lane * laneStride + i * channels] = states[lane].predictor * (1.0f / 32768.0f);
+        }
+    }
+#endif
+}
+
+} // namespace detail
+
+/**
+ * @brief Samples compressed with IMA ADPCM, 4 bits per sample, decoded a block at a time.
+ *
+ * Resident size is about a quarter of AUDIO_S16 and an eighth of AUDIO_F32.
+ * Every block carries its own decoder state, so any block decodes independently.
+ * Within a block each channel is split into 4 sub-blocks with their own state,
+ * which decode side by side in SIMD lanes, since ADPCM is serial within a stream.
+ */
+class AdpcmSamples
+{
+public:
+    // frames per block, the seek granularity
+    static constexpr std::uint32_t BLOCK_FRAMES = detail::ADPCM_LANES * detail::ADPCM_LANE_FRAMES;
+
+    /**
+     * @param frames  Interleaved native endian 16 bit samples
+     */
+    AdpcmSamples(const std::int16_t* frames, std::uint32_t frameCount, int freq, std::uint8_t channels);
+
+    /**
+     * @brief Compress a Wav of any format convert() supports.
+     * @throws SdlError
+     */
+    explicit AdpcmSamples(const Wav& wav);
+
+    int getFreq() const;
+
+    std::uint8_t getChannels() const;
+
+    std::uint32_t getFrameCount() const;
+
+    std::uint32_t getNumBlocks() const;
+
+    /**
+     * @brief Get the compressed size.
+     */
+    std::size_t getSizeBytes() const;
+
+    /**
+     * @brief Get the size of the samples this was compressed from.
+     */
+    std::size_t getSourceSizeBytes() const;
+
+    /**
+     * @brief Get the memory saved by keeping these instead of the source samples.
+     */
+    std::size_t getSavedBytes() const;
+
+    /**
+     * @brief Decode a block. Never allocates, safe inside an audio callback.
+     * @param out  Room for BLOCK_FRAMES interleaved float frames
+     * @return Number of frames decoded, fewer than BLOCK_FRAMES for the last block
+     */
+    std::uint32_t decodeBlock(std::uint32_t block, float* out) const;
+
+private:
+    void encode(const std::int16_t* frames);
+
+    std::vector<std::uint8_t> _data {};
+    int _freq;
+    std::uint8_t _channels;
+    std::uint32_t _frameCount;
+    std::size_t _sourceSizeBytes;
+};
+
+/**
+ * @brief Reads AdpcmSamples as a stream of float frames, decoding blocks on demand.
+ *
+ * Allocates once, on construction, so reading and seeking are safe inside an audio callback.
+ */
+class AdpcmReader
+{
+public:
+    /**
+     * @param samples  Must outlive the reader
+     */
+    explicit AdpcmReader(const AdpcmSamples& samples, bool loop = false);
+
+    /**
+     * @brief Move to a frame, which costs at most one block decode on the next read.
+     */
+    void seek(std::uint32_t frame);
+
+    std::uint32_t getPosition() const;
+
+    /**
+     * @brief Decode interleaved float frames.
+     * @return Number of frames read, fewer than requested at the end unless looping
+     */
+    std::uint32_t read(float* out, std::uint32_t frames);
+
+    /**
+     * @brief SDL_AudioCallback for an AUDIO_F32SYS AudioDevice with matching channels, pass the AdpcmReader as userdata.
+     *
+     * Fills with silence after the end.
+     */
+    static void callback(void* userdata, std::uint8_t* stream, int len);
+
+private:
+    static constexpr std::uint32_t NO_BLOCK = ~std::uint32_t{};
+
+    const AdpcmSamples& _samples;
+    bool _loop;
+    std::vector<float> _block;
+    std::uint32_t _decodedBlock {NO_BLOCK};
+    std::uint32_t _decodedFrames {};
+    std::uint32_t _position {};
+};
+
+inline AdpcmSamples::AdpcmSamples(const std::int16_t* frames, std::uint32_t frameCount, int freq, std::uint8_t channels)
+    : _freq(freq),
+      _channels(channels),
+      _frameCount(frameCount),
+      _sourceSizeBytes(std::size_t{frameCount} * channels * sizeof(std::int16_t))
+{
+    assert(channels > 0);
+    encode(frames);
+}
+
+inline AdpcmSamples::AdpcmSamples(const Wav& wav)
+    : _freq(wav.getFreq()),
+      _channels(wav.getChannels()),
+      _frameCount(wav.getSizeBytes() / (SDL_AUDIO_BITSIZE(wav.getAudioFormat()) / 8 * wav.getChannels())),
+      _sourceSizeBytes(wav.getSizeBytes())
+{
+    std::vector<std::int16_t> frames(std::size_t{_frameCount} * _channels);
+    convert(wav.getAudioFormat(), AUDIO_S16SYS, wav.begin(), frames.data(), frames.size());
+    encode(frames.data());
+}
+
+inline int AdpcmSamples::getFreq() const
+{
+    return _freq;
+}
+
+inline std::uint8_t AdpcmSamples::getChannels() const
+{
+    return _channels;
+}
+
+inline std::uint32_t AdpcmSamples::getFrameCount() const
+{
+    return _frameCount;
+}
+
+inline std::uint32_t AdpcmSamples::getNumBlocks() const
+{
+    return (_frameCount + BLOCK_FRAMES - 1) / BLOCK_FRAMES;
+}
+
+inline std::size_t AdpcmSamples::getSizeBytes() const
+{
+    return _data.size();
+}
+
+inline std::size_t AdpcmSamples::getSourceSizeBytes() const
+{
+    return _sourceSizeBytes;
+}
+
+inline std::size_t AdpcmSamples::getSavedBytes() const
+{
+    return _sourceSizeBytes > _data.size() ? _sourceSizeBytes - _data.size() : 0;
+}
+
+inline std::uint32_t AdpcmSamples::decodeBlock(std::uint32_t block, float* out) const
+{
+    assert(block < getNumBlocks());
+    const std::uint8_t* src = _data.data() + std::size_t{block} * _channels * detail::ADPCM_CHANNEL_BLOCK_BYTES;
+    for(std::uint8_t channel = 0; channel < _channels; ++channel) {
+        detail::decodeAdpcmChannel(src + channel * detail::ADPCM_CHANNEL_BLOCK_BYTES, out + channel, _channels);
+    }
+    return std::min(BLOCK_FRAMES, _frameCount - block * BLOCK_FRAMES);
+}
+
+inline void AdpcmSamples::encode(const std::int16_t* frames)
+{
+    _data.resize(std::size_t{getNumBlocks()} * _channels * detail::ADPCM_CHANNEL_BLOCK_BYTES);
+
+    for(std::uint8_t channel = 0; channel < _channels; ++channel) {
+        // carry the step index across sub-blocks, so each starts already adapted
+        detail::AdpcmState state {0, 0};
+        for(std::uint32_t block = 0; block < getNumBlocks(); ++block) {
+            std::uint8_t* dst = _data.data() + (std::size_t{block} * _channels + channel) * detail::ADPCM_CHANNEL_BLOCK_BYTES;
+            std::uint8_t* words = dst + detail::ADPCM_LANES * 4;
+
+            for(std::uint32_t lane = 0; lane < detail::ADPCM_LANES; ++lane) {
+                std::uint32_t start = block * BLOCK_FRAMES + lane * detail::ADPCM_LANE_FRAMES;
+
+                // predict from the exact previous sample
+                state.predictor = start > 0 && start <= _frameCount ? frames[std::size_t{start - 1} * _channels + channel] : 0;
+                std::int16_t predictor = static_cast<std::int16_t>(state.predictor);
+                std::memcpy(dst + lane * 4, &predictor, sizeof(predictor));
+                dst[lane * 4 + 2] = static_cast<std::uint8_t>(state.index);
+                dst[lane * 4 + 3] = 0;
+
+                for(std::uint32_t i = 0; i < detail::ADPCM_LANE_FRAMES; ++i) {
+                    // hold the last sample past the end
+                    std::uint32_t frame = std::min(start + i, _frameCount - 1);
+                    std::uint32_t nibble = detail::encodeAdpcmNibble(state, frames[std::size_t{frame} * _channels + channel]);
+
+                    std::uint16_t word;
+                    std::memcpy(&word, words + i * 2, sizeof(word));
+                    word = static_cast<std::uint16_t>(word | nibble << (lane * 4));
+                    std::memcpy(words + i * 2, &word, sizeof(word));
+                }
+            }
+        }
+    }
+}
+
+inline AdpcmReader::AdpcmReader(const AdpcmSamples& samples, bool loop)
+    : _samples(samples),
+      _loop(loop),
+      _block(std::size_t{AdpcmSamples::BLOCK_FRAMES} * samples.getChannels())
+{
+}
+
+inline void AdpcmReader::seek(std::uint32_t frame)
+{
+    _position = std::min(frame, _samples.getFrameCount());
+}
+
+inline std::uint32_t AdpcmReader::getPosition() const
+{
+    return _position;
+}
+
+inline std::uint32_t AdpcmReader::read(float* out, std::uint32_t frames)
+{
+    const std::uint8_t channels = _samples.getChannels();
+    std::uint32_t done = 0;
+    while(done < frames) {
+        if(_position >= _samples.getFrameCount()) {
+            if(!_loop || _samples.getFrameCount() == 0) {
+                break;
+            }
+            _position = 0;
+        }
+
+        std::uint32_t block = _position / AdpcmSamples::BLOCK_FRAMES;
+        if(block != _decodedBlock) {
+            _decodedFrames = _samples.decodeBlock(block, _block.data());
+            _decodedBlock = block;
+        }
+
+        std::uint32_t offset = _position - block * AdpcmSamples::BLOCK_FRAMES;
+        std::uint32_t n = std::min(frames - done, _decodedFrames - offset);
+        std::copy(_block.begin() + std::size_t{offset} * channels, _block.begin() + std::size_t{offset + n} * channels, out + std::size_t{done} * channels);
+        done += n;
+        _position += n;
+    }
+    return done;
+}
+
+inline void AdpcmReader::callback(void* userdata, std::uint8_t* stream, int len)
+{
+    AdpcmReader* reader = reinterpret_cast<AdpcmReader*>(userdata);
+    std::uint32_t frameSize = reader->_samples.getChannels() * sizeof(float);
+    std::uint32_t read = reader->read(reinterpret_cast<float*>(stream), static_cast<std::uint32_t>(len) / frameSize);
+    std::memset(stream + read * frameSize, 0, len - read * frameSize);
+}
+
+} // namespace sdlwrapper
+
+#endif // SDLWRAPPER_ADPCM_HPP
@@ -19,16 +19,34 @@
 #include "sdlwrapper/sdl_error.hpp"
 #include "sdlwrapper/sdl.hpp"
 #include "sdlwrapper/detail/audio_sample_type.hpp"
+#include "sdlwrapper/detail/mapped_file.hpp"
+#include "sdlwrapper/detail/spsc_ring_buffer.hpp"
+#include "sdlwrapper/detail/wav_header.hpp"
+
+#include "sdlwrapper/audio_rt_check.hpp"
+
+#ifdef SDLWRAPPER_AUDIO_INSTRUMENTATION
+    #include "sdlwrapper/audio_instrumentation.hpp"
+#endif
 
 #include <boost/integer.hpp>
 
-#include <optional>
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <memory>
 #include <functional>
+#include <type_traits>
 
 #if (SDL_MAJOR_VERSION > 2 || SDL_MAJOR_VERSION == 2 && SDL_MINOR_VERSION > 0 || SDL_MAJOR_VERSION == 2 && SDL_MINOR_VERSION == 0 && SDL_PATCHLEVEL >= 4)
     #define SDLWRAPPER_AUDIO_SUPPORTS_NONCALLBACK
 #endif
 
+#if defined(SDLWRAPPER_AUDIO_INSTRUMENTATION) || defined(SDLWRAPPER_AUDIO_RT_CHECK)
+    // callbacks are wrapped in a trampoline which times or checks them
+    #define SDLWRAPPER_AUDIO_WRAP_CALLBACK
+#endif
+
 namespace sdlwrapper
 {
 
@@ -43,8 +61,78 @@ struct AudioFormatTraits
     static constexpr bool sampleFloating = SDL_AUDIO_ISFLOAT(Format);
     static constexpr bool sampleIntegral = SDL_AUDIO_ISINT(Format);
     static constexpr std::uint16_t sampleBitSize = SDL_AUDIO_BITSIZE(Format);
+    static constexpr bool sampleNativeEndian = sampleBitSize == 8 || sampleBigEndian == (SDL_BYTEORDER == SDL_BIG_ENDIAN);
 
     using SampleType = detail::AudioSampleType<sampleFloating, sampleBitSize, sampleSigned>;
+
+    // unsigned samples are silent at their midpoint, which is 0x80 in the low byte when byte swapped
+    static constexpr SampleType silence = detail::audioSampleSilence<SampleType>(sampleNativeEndian);
+};
+
+/**
+ * @brief Selects a compile time sample format in AudioDevice constructors, for example AudioFormatConstant<AUDIO_F32SYS>{}.
+ */
+template <AudioFormat Format>
+using AudioFormatConstant = std::integral_constant<AudioFormat, Format>;
+
+/**
+ * @brief Non-owning view of interleaved samples in an audio stream.
+ */
+template <typename T>
+class AudioSpan
+{
+public:
+    AudioSpan(T* data, std::size_t size);
+
+    T* begin() const;
+    T* end() const;
+
+    T* getData() const;
+
+    /**
+     * @brief Get the number of samples, which is frames * channels.
+     */
+    std::size_t getSize() const;
+
+    T& operator[](std::size_t index) const;
+
+private:
+    T* _data;
+    std::size_t _size;
+};
+
+/**
+ * @brief Wait-free single producer, single consumer queue of samples.
+ *
+ * Feeds an AudioDevice without AudioDevice::lock().
+ * One thread writes samples, and the audio callback drains them.
+ */
+template <AudioFormat Format>
+class AudioRingBuffer : public detail::SpscRingBuffer<typename AudioFormatTraits<Format>::SampleType>
+{
+public:
+    using SampleType = typename AudioFormatTraits<Format>::SampleType;
+
+    /**
+     * @param capacity  Buffer size in samples, rounded up to a power of two
+     */
+    explicit AudioRingBuffer(std::size_t capacity);
+
+    /**
+     * @brief Read exactly count samples, filling any shortfall with silence. Consumer only.
+     *
+     * A shortfall counts as one underrun.
+     * @return Number of samples read from the buffer
+     */
+    std::size_t drain(SampleType* data, std::size_t count);
+
+    /**
+     * @brief Get the number of drains which ran out of samples.
+     */
+    std::uint64_t getUnderruns() const;
+
+private:
+    std::atomic<std::uint64_t> _underruns {};
 };
 
 namespace detail
@@ -66,14 +154,47 @@ struct AudioDeviceDeleter
     }
 };
 
+#ifdef SDLWRAPPER_AUDIO_WRAP_CALLBACK
+// wraps whichever callback the device was opened with
+struct WrappedCallback
+{
+    SDL_AudioCallback callback {};
+    void* userdata {};
+#ifdef SDLWRAPPER_AUDIO_INSTRUMENTATION
+    AudioCallbackStats stats {};
+#endif // SDLWRAPPER_AUDIO_INSTRUMENTATION
+};
+#endif // SDLWRAPPER_AUDIO_WRAP_CALLBACK
+
 } // namespace detail
 
+enum class WavLoadMode
+{
+    // decode with SDL_LoadWAV into a heap buffer
+    COPY,
+    // memory map the file, and play the samples in place
+    MAP
+};
+
 class Wav
 {
 public:
     Wav() = default;
     explicit Wav(const AudioSubsystem&, const char* fileName);
 
+    /**
+     * @brief Load a WAV file, optionally memory mapped.
+     *
+     * WavLoadMode::MAP points begin() and end() into the file's mapped data chunk, without copying.
+     * Pages are only read when the samples are touched, and are shared with other processes
+     * mapping the same file. Only uncompressed PCM and float files can be mapped.
+     * If the data chunk doesn't start on a multiple of the sample size, as after an 18 byte fmt chunk,
+     * the file is copied instead, so samples are always aligned. Check with isMapped().
+     *
+     * @throws SdlError
+     */
+    Wav(const AudioSubsystem&, const char* fileName, WavLoadMode mode);
+
     std::uint32_t getSizeBytes() const;
 
     int getFreq() const;
@@ -88,8 +209,12 @@ public:
     std::uint8_t* end();
     const std::uint8_t* end() const;
 
+    bool isMapped() const;
+
 private:
     cwrapper::Resource<std::uint8_t*, detail::WavDeleter> _resource {};
+    std::unique_ptr<detail::MappedFile> _mapping {};
+    std::uint32_t _mappedOffset {};
     std::uint32_t _sizeBytes {};
     int _freq {};
     AudioFormat _format {};
@@ -138,6 +263,42 @@ public:
      */
     AudioDevice(const AudioSubsystem&, const char* name, bool capture, int freq, AudioFormat format, std::uint8_t channels, std::uint16_t samples, SDL_AudioCallback callback, void* userData = nullptr, AudioSpecChanges allowedChanges = {});
 
+    /**
+     * @brief Open an audio device which calls a callable object with typed samples.
+     *
+     * The callable is invoked directly, without type erasure or allocation, as
+     * callback(AudioSpan<AudioFormatTraits<Format>::SampleType>).
+     * The device refers to the callable, so it must outlive the device,
+     * and the device can be moved freely.
+     *
+     * @param name  Device name
+     * @param capture  Open a recording device instead of an output device
+     * @param freq  Sample rate in Hz
+     * @param format  Format for each sample, as AudioFormatConstant<Format>{}
+     * @param channels  Number of audio channels
+     * @param samples  Buffer size in samples
+     * @param callback  Called when audio is required (for output devices) or available (for capture devices)
+     * @param allowedChanges  Any of the AudioSpecChanges bit flags OR'd together, except FORMAT.
+     */
+    template <AudioFormat Format, typename Callable>
+    AudioDevice(const AudioSubsystem&, const char* name, bool capture, int freq, AudioFormatConstant<Format> format, std::uint8_t channels, std::uint16_t samples, Callable& callback, AudioSpecChanges allowedChanges = {});
+
+    /**
+     * @brief Open an output device which drains an AudioRingBuffer from the audio thread.
+     *
+     * The audio thread never blocks, it plays silence and counts an underrun when the buffer runs dry.
+     * The ring buffer must outlive the device.
+     *
+     * @param name  Device name
+     * @param freq  Sample rate in Hz
+     * @param channels  Number of audio channels
+     * @param samples  Buffer size in samples
+     * @param ringBuffer  Interleaved samples to play, the device format is Format
+     * @param allowedChanges  Any of the AudioSpecChanges bit flags OR'd together, except FORMAT.
+     */
+    template <AudioFormat Format>
+    AudioDevice(const AudioSubsystem&, const char* name, int freq, std::uint8_t channels, std::uint16_t samples, AudioRingBuffer<Format>& ringBuffer, AudioSpecChanges allowedChanges = {});
+
 #ifdef SDLWRAPPER_AUDIO_SUPPORTS_NONCALLBACK
     /**
      * @brief Open an audio device with no callback, to be used with queue or deque.
@@ -191,19 +352,104 @@ public:
     std::uint32_t getQueueSize() const;
 #endif // SDLWRAPPER_AUDIO_SUPPORTS_NONCALLBACK
 
+#ifdef SDLWRAPPER_AUDIO_INSTRUMENTATION
+    /**
+     * @brief Get the timing of every callback so far. Readable from any thread without locking.
+     *
+     * Only available when SDLWRAPPER_AUDIO_INSTRUMENTATION is defined,
+     * otherwise callbacks are not wrapped and cost nothing extra.
+     */
+    const AudioCallbackStats& getCallbackStats() const;
+#endif // SDLWRAPPER_AUDIO_INSTRUMENTATION
+
     static int getNumAudioDevices(const AudioSubsystem&, bool capture = false);
     static const char* getAudioDeviceName(const AudioSubsystem&, int index, bool capture = false);
 
 private:
     void init(const char* name, bool capture, const SDL_AudioSpec& desiredSpec, AudioSpecChanges allowedChanges);
 
-    std::optional<Callback> _optCallback {};
+    // heap allocated so the address given to SDL survives moving the device
+    std::unique_ptr<Callback> _callback {};
+#ifdef SDLWRAPPER_AUDIO_WRAP_CALLBACK
+    std::unique_ptr<detail::WrappedCallback> _wrappedCallback {};
+#endif // SDLWRAPPER_AUDIO_WRAP_CALLBACK
     cwrapper::Resource<SDL_AudioDeviceID, detail::AudioDeviceDeleter> _resource {};
     SDL_AudioSpec _obtainedSpec {};
 
     static void dispatchCallback(void* userdata, std::uint8_t* stream, int len);
+
+    template <AudioFormat Format>
+    static void dispatchRingBuffer(void* userdata, std::uint8_t* stream, int len);
+
+    template <AudioFormat Format, typename Callable>
+    static void dispatchTyped(void* userdata, std::uint8_t* stream, int len);
+
+#ifdef SDLWRAPPER_AUDIO_WRAP_CALLBACK
+    static void dispatchWrapped(void* userdata, std::uint8_t* stream, int len);
+#endif // SDLWRAPPER_AUDIO_WRAP_CALLBACK
 };
 
+template <typename T>
+AudioSpan<T>::AudioSpan(T* data, std::size_t size)
+    : _data(data),
+      _size(size)
+{
+}
+
+template <typename T>
+T* AudioSpan<T>::begin() const
+{
+    return _data;
+}
+
+template <typename T>
+T* AudioSpan<T>::end() const
+{
+    return _data + _size;
+}
+
+template <typename T>
+T* AudioSpan<T>::getData() const
+{
+    return _data;
+}
+
+template <typename T>
+std::size_t AudioSpan<T>::getSize() const
+{
+    return _size;
+}
+
+template <typename T>
+T& AudioSpan<T>::operator[](std::size_t index) const
+{
+    assert(index < _size);
+    return _data[index];
+}
+
+template <AudioFormat Format>
+AudioRingBuffer<Format>::AudioRingBuffer(std::size_t capacity)
+    : detail::SpscRingBuffer<SampleType>(capacity)
+{
+}
+
+template <AudioFormat Format>
+std::size_t AudioRingBuffer<Format>::drain(SampleType* data, std::size_t count)
+{
+    std::size_t numRead = this->read(data, count);
+    if(numRead < count) {
+        std::fill(data + numRead, data + count, AudioFormatTraits<Format>::silence);
+        _underruns.fetch_add(1, std::memory_order_relaxed);
+    }
+    return numRead;
+}
+
+template <AudioFormat Format>
+std::uint64_t AudioRingBuffer<Format>::getUnderruns() const
+{
+    return _underruns.load(std::memory_order_relaxed);
+}
+
 inline Wav::Wav(const AudioSubsystem&, const char *fileName)
 {
     SDL_AudioSpec spec;
@@ -217,6 +463,42 @@ inline Wav::Wav(const AudioSubsystem&, const char *fileName)
     _channels = spec.channels;
 }
 
+inline Wav::Wav(const AudioSubsystem& subsystem, const char *fileName, WavLoadMode mode)
+{
+    if(mode == WavLoadMode::COPY) {
+        *this = Wav{subsystem, fileName};
+        return;
+    }
+
+    _mapping = std::make_unique<detail::MappedFile>(fileName);
+
+    // SDL_RWFromConstMem takes an int size
+    if(_mapping->getSize() > static_cast<std::size_t>(INT_MAX)) {
+        detail::throwWavError("file larger than 2 GiB can't be mapped");
+    }
+
+    detail::WavHeader header;
+    {
+        cwrapper::Resource<SDL_RWops*, detail::RWopsDeleter> rw {SDL_RWFromConstMem(_mapping->getData(), static_cast<int>(_mapping->getSize()))};
+        if(!rw.hasHandle()) {
+            throw SdlError{};
+        }
+        header = detail::readWavHeader(rw.getHandle());
+    }
+
+    // the mapping is page aligned, but RIFF chunks only to 2 bytes, so samples may straddle their alignment
+    if(header.dataOffset % (SDL_AUDIO_BITSIZE(header.format) / 8) != 0) {
+        *this = Wav{subsystem, fileName};
+        return;
+    }
+
+    _mappedOffset = header.dataOffset;
+    _sizeBytes = header.dataSize;
+    _freq = header.freq;
+    _format = header.format;
+    _channels = header.channels;
+}
+
 inline uint32_t Wav::getSizeBytes() const
 {
     return _sizeBytes;
@@ -239,26 +521,31 @@ inline uint8_t Wav::getChannels() const
 
 inline uint8_t* Wav::begin()
 {
-    return _resource.getHandle();
+    return _mapping ? _mapping->getData() + _mappedOffset : _resource.getHandle();
 }
 
 inline const uint8_t* Wav::begin() const
 {
-    return _resource.getHandle();
+    return _mapping ? _mapping->getData() + _mappedOffset : _resource.getHandle();
 }
 
 inline uint8_t* Wav::end()
 {
-    return _resource.getHandle() + _sizeBytes;
+    return begin() + _sizeBytes;
 }
 
 inline const uint8_t* Wav::end() const
 {
-    return _resource.getHandle() + _sizeBytes;
+    return begin() + _sizeBytes;
+}
+
+inline bool Wav::isMapped() const
+{
+    return _mapping != nullptr;
 }
 
 inline AudioDevice::AudioDevice(const AudioSubsystem&, const char *name, bool capture, int freq, AudioFormat format, uint8_t channels, uint16_t samples, AudioDevice::Callback callback, AudioSpecChanges allowedChanges)
-    : _optCallback(callback)
+    : _callback(std::make_unique<Callback>(std::move(callback)))
 {
     SDL_AudioSpec desiredSpec {};
     desiredSpec.freq = freq;
@@ -266,7 +553,7 @@ inline AudioDevice::AudioDevice(const AudioSubsystem&, const char *name, bool ca
     desiredSpec.channels = channels;
     desiredSpec.samples = samples;
     desiredSpec.callback = dispatchCallback;
-    desiredSpec.userdata = &_optCallback.value();
+    desiredSpec.userdata = _callback.get();
 
     init(name, capture, desiredSpec, allowedChanges);
 }
@@ -284,6 +571,38 @@ inline AudioDevice::AudioDevice(const AudioSubsystem&, const char *name, bool ca
     init(name, capture, desiredSpec, allowedChanges);
 }
 
+template <AudioFormat Format>
+AudioDevice::AudioDevice(const AudioSubsystem&, const char* name, int freq, uint8_t channels, uint16_t samples, AudioRingBuffer<Format>& ringBuffer, AudioSpecChanges allowedChanges)
+{
+    assert((static_cast<int>(allowedChanges) & SDL_AUDIO_ALLOW_FORMAT_CHANGE) == 0);
+
+    SDL_AudioSpec desiredSpec {};
+    desiredSpec.freq = freq;
+    desiredSpec.format = Format;
+    desiredSpec.channels = channels;
+    desiredSpec.samples = samples;
+    desiredSpec.callback = dispatchRingBuffer<Format>;
+    desiredSpec.userdata = &ringBuffer;
+
+    init(name, false, desiredSpec, allowedChanges);
+}
+
+template <AudioFormat Format, typename Callable>
+AudioDevice::AudioDevice(const AudioSubsystem&, const char* name, bool capture, int freq, AudioFormatConstant<Format>, uint8_t channels, uint16_t samples, Callable& callback, AudioSpecChanges allowedChanges)
+{
+    assert((static_cast<int>(allowedChanges) & SDL_AUDIO_ALLOW_FORMAT_CHANGE) == 0);
+
+    SDL_AudioSpec desiredSpec {};
+    desiredSpec.freq = freq;
+    desiredSpec.format = Format;
+    desiredSpec.channels = channels;
+    desiredSpec.samples = samples;
+    desiredSpec.callback = dispatchTyped<Format, Callable>;
+    desiredSpec.userdata = const_cast<void*>(static_cast<const void*>(std::addressof(callback)));
+
+    init(name, capture, desiredSpec, allowedChanges);
+}
+
 #ifdef SDLWRAPPER_AUDIO_SUPPORTS_NONCALLBACK
 inline AudioDevice::AudioDevice(const AudioSubsystem &, const char *name, bool capture, int freq, AudioFormat format, uint8_t channels, uint16_t samples, AudioSpecChanges allowedChanges)
 {
@@ -324,6 +643,7 @@ inline void AudioDevice::pause()
 inline void AudioDevice::lock()
 {
     assert(_resource.hasHandle());
+    checkAudioRt(AudioRtViolation::LOCK, "AudioDevice::lock");
     SDL_LockAudioDevice(_resource.getHandle());
 }
 
@@ -375,12 +695,39 @@ inline const char* AudioDevice::getAudioDeviceName(const AudioSubsystem&, int in
     return name;
 }
 
+#ifdef SDLWRAPPER_AUDIO_INSTRUMENTATION
+inline const AudioCallbackStats& AudioDevice::getCallbackStats() const
+{
+    assert(_wrappedCallback);
+    return _wrappedCallback->stats;
+}
+#endif // SDLWRAPPER_AUDIO_INSTRUMENTATION
+
 inline void AudioDevice::init(const char *name, bool capture, const SDL_AudioSpec& desiredSpec, AudioSpecChanges allowedChanges)
 {
+#ifdef SDLWRAPPER_AUDIO_WRAP_CALLBACK
+    SDL_AudioSpec wrappedSpec = desiredSpec;
+    if(desiredSpec.callback != nullptr) {
+        _wrappedCallback = std::make_unique<detail::WrappedCallback>();
+        _wrappedCallback->callback = desiredSpec.callback;
+        _wrappedCallback->userdata = desiredSpec.userdata;
+        wrappedSpec.callback = dispatchWrapped;
+        wrappedSpec.userdata = _wrappedCallback.get();
+    }
+    _resource.setHandle(SDL_OpenAudioDevice(name, capture, &wrappedSpec, &_obtainedSpec, static_cast<int>(allowedChanges)));
+#else
     _resource.setHandle(SDL_OpenAudioDevice(name, capture, &desiredSpec, &_obtainedSpec, static_cast<int>(allowedChanges)));
+#endif // SDLWRAPPER_AUDIO_WRAP_CALLBACK
     if(!_resource.hasHandle()) {
         throw SdlError{};
     }
+
+#ifdef SDLWRAPPER_AUDIO_INSTRUMENTATION
+    // devices open paused, so no callback has run yet
+    if(_wrappedCallback) {
+        _wrappedCallback->stats.setDeadline(static_cast<std::uint32_t>(std::uint64_t{_obtainedSpec.samples} * 1000000 / _obtainedSpec.freq));
+    }
+#endif // SDLWRAPPER_AUDIO_INSTRUMENTATION
 }
 
 inline void AudioDevice::dispatchCallback(void *userdata, uint8_t *stream, int len)
@@ -388,6 +735,39 @@ inline void AudioDevice::dispatchCallback(void *userdata, uint8_t *stream, int l
     reinterpret_cast<Callback*>(userdata)->operator()(stream, len);
 }
 
+template <AudioFormat Format>
+void AudioDevice::dispatchRingBuffer(void *userdata, uint8_t *stream, int len)
+{
+    using SampleType = typename AudioFormatTraits<Format>::SampleType;
+    reinterpret_cast<AudioRingBuffer<Format>*>(userdata)->drain(reinterpret_cast<SampleType*>(stream), len / sizeof(SampleType));
+}
+
+#ifdef SDLWRAPPER_AUDIO_WRAP_CALLBACK
+inline void AudioDevice::dispatchWrapped(void *userdata, uint8_t *stream, int len)
+{
+    detail::WrappedCallback* wrapped = reinterpret_cast<detail::WrappedCallback*>(userdata);
+#ifdef SDLWRAPPER_AUDIO_INSTRUMENTATION
+    std::uint64_t start = SDL_GetPerformanceCounter();
+#endif // SDLWRAPPER_AUDIO_INSTRUMENTATION
+    {
+#ifdef SDLWRAPPER_AUDIO_RT_CHECK
+        detail::AudioThreadScope audioThread;
+#endif // SDLWRAPPER_AUDIO_RT_CHECK
+        wrapped->callback(wrapped->userdata, stream, len);
+    }
+#ifdef SDLWRAPPER_AUDIO_INSTRUMENTATION
+    wrapped->stats.record(start, SDL_GetPerformanceCounter());
+#endif // SDLWRAPPER_AUDIO_INSTRUMENTATION
+}
+#endif // SDLWRAPPER_AUDIO_WRAP_CALLBACK
+
+template <AudioFormat Format, typename Callable>
+void AudioDevice::dispatchTyped(void *userdata, uint8_t *stream, int len)
+{
+    using SampleType = typename AudioFormatTraits<Format>::SampleType;
+    (*static_cast<Callable*>(userdata))(AudioSpan<SampleType>{reinterpret_cast<SampleType*>(stream), len / sizeof(SampleType)});
+}
+
 } // namespace sdlwrapper
 
 namespace cwrapper
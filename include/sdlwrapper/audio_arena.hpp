@@ -0,0 +1,153 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef SDLWRAPPER_AUDIO_ARENA_HPP
+#define SDLWRAPPER_AUDIO_ARENA_HPP
+
+#include "sdlwrapper/audio.hpp"
+#include "sdlwrapper/detail/spsc_ring_buffer.hpp"
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+namespace sdlwrapper
+{
+
+/**
+ * @brief Bump allocator for scratch buffers inside an audio callback.
+ *
+ * Memory is allocated once, up front. Call reset() at the start of every callback,
+ * then allocate as many cache-line aligned buffers as fit. Nothing is freed individually.
+ * One thread may use an arena at a time, usually the audio thread.
+ */
+class AudioArena
+{
+public:
+    /**
+     * @param capacityBytes  Total size of every buffer allocated between resets, including alignment padding
+     */
+    explicit AudioArena(std::size_t capacityBytes);
+
+    /**
+     * @brief Make room for a number of float buffers, each holding one callback's samples.
+     * @param spec  Usually AudioDevice::getObtainedSpec()
+     * @param buffers  Number of samples * channels float buffers needed per callback
+     */
+    AudioArena(const SDL_AudioSpec& spec, std::size_t buffers);
+
+    AudioArena(const AudioArena&) = delete;
+    AudioArena& operator=(const AudioArena&) = delete;
+
+    /**
+     * @brief Allocate uninitialized, cache-line aligned storage. Never calls the heap.
+     * @return Span of count elements, or an empty span if the arena is exhausted
+     */
+    template <typename T>
+    AudioSpan<T> allocate(std::size_t count);
+
+    /**
+     * @brief Release every allocation at once.
+     */
+    void reset();
+
+    std::size_t getCapacity() const;
+
+    /**
+     * @brief Get the number of bytes allocated since the last reset.
+     */
+    std::size_t getUsed() const;
+
+    /**
+     * @brief Get the most bytes ever allocated between resets.
+     */
+    std::size_t getHighWater() const;
+
+    /**
+     * @brief Get the number of allocations which did not fit.
+     */
+    std::uint64_t getFailures() const;
+
+private:
+    std::unique_ptr<std::uint8_t[]> _storage;
+    std::uint8_t* _base;
+    std::size_t _capacity;
+    std::size_t _used {};
+    std::size_t _highWater {};
+    std::uint64_t _failures {};
+};
+
+inline AudioArena::AudioArena(std::size_t capacityBytes)
+    : _storage(new std::uint8_t[capacityBytes + detail::CACHE_LINE_SIZE]),
+      _capacity(capacityBytes)
+{
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(_storage.get());
+    _base = _storage.get() + (detail::CACHE_LINE_SIZE - address % detail::CACHE_LINE_SIZE) % detail::CACHE_LINE_SIZE;
+}
+
+inline AudioArena::AudioArena(const SDL_AudioSpec& spec, std::size_t buffers)
+    : AudioArena(buffers * ((std::size_t{spec.samples} * spec.channels * sizeof(float) + detail::CACHE_LINE_SIZE - 1) / detail::CACHE_LINE_SIZE * detail::CACHE_LINE_SIZE))
+{
+}
+
+template <typename T>
+AudioSpan<T> AudioArena::allocate(std::size_t count)
+{
+    static_assert(std::is_trivially_destructible_v<T>, "AudioArena never runs destructors");
+    static_assert(alignof(T) <= detail::CACHE_LINE_SIZE, "AudioArena aligns to cache lines");
+
+    std::size_t size = (count * sizeof(T) + detail::CACHE_LINE_SIZE - 1) / detail::CACHE_LINE_SIZE * detail::CACHE_LINE_SIZE;
+    if(size > _capacity - _used) {
+        ++_failures;
+        return {nullptr, 0};
+    }
+
+    T* data = reinterpret_cast<T*>(_base + _used);
+    _used += size;
+    _highWater = std::max(_highWater, _used);
+    return {data, count};
+}
+
+inline void AudioArena::reset()
+{
+    _used = 0;
+}
+
+inline std::size_t AudioArena::getCapacity() const
+{
+    return _capacity;
+}
+
+inline std::size_t AudioArena::getUsed() const
+{
+    return _used;
+}
+
+inline std::size_t AudioArena::getHighWater() const
+{
+    return _highWater;
+}
+
+inline std::uint64_t AudioArena::getFailures() const
+{
+    return _failures;
+}
+
+} // namespace sdlwrapper
+
+#endif // SDLWRAPPER_AUDIO_ARENA_HPP
@@ -0,0 +1,312 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef SDLWRAPPER_AUDIO_CALIBRATION_HPP
+#define SDLWRAPPER_AUDIO_CALIBRATION_HPP
+
+#include "sdlwrapper/audio.hpp"
+#include "sdlwrapper/sdl_error.hpp"
+#include "sdlwrapper/detail/rwops.hpp"
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace sdlwrapper
+{
+
+struct AudioCalibrationOptions
+{
+    int freq = 48000;
+    AudioFormat format = AUDIO_F32SYS;
+    std::uint8_t channels = 2;
+
+    // buffer sizes tried, halving from the largest
+    std::uint16_t maxSamples = 4096;
+    std::uint16_t minSamples = 64;
+
+    // time measured per buffer size, after the first few callbacks
+    std::uint32_t windowMs = 250;
+
+    // largest 99th percentile deviation of the callback interval, as a fraction of one buffer's duration
+    double maxJitter = 0.25;
+
+    // most underruns allowed in one window
+    std::uint32_t maxUnderruns = 0;
+
+    // representative work run inside each callback, its output is replaced with silence
+    SDL_AudioCallback load = nullptr;
+    void* userdata = nullptr;
+};
+
+struct AudioCalibrationResult
+{
+    // buffer size to pass to AudioDevice
+    std::uint16_t samples;
+    // buffer size the device actually used
+    std::uint16_t obtainedSamples;
+    // duration of one obtained buffer
+    std::uint32_t latencyUs;
+    // 99th percentile deviation of the callback interval, as a fraction of latencyUs
+    double jitter;
+    // callbacks which overran their buffer, or started more than a buffer late
+    std::uint32_t underruns;
+    // false if even maxSamples missed the targets
+    bool stable;
+};
+
+/**
+ * @brief Find the smallest buffer size at which an output device's callbacks stay on time.
+ *
+ * Opens the device once per buffer size, from largest to smallest, and times every callback
+ * for options.windowMs. Stops at the first size which misses the jitter or underrun target,
+ * or which the device does not honor. Takes about (windowMs + 100) * sizes tried, and plays silence.
+ *
+ * @param name  Device name, or nullptr for the default device
+ * @throws SdlError if the device can't be opened
+ */
+AudioCalibrationResult calibrateAudioDevice(const AudioSubsystem&, const char* name, const AudioCalibrationOptions& options = {});
+
+/**
+ * @brief Calibrated buffer sizes by device name, persisted in a text file.
+ *
+ * Buffer sizes depend on the machine, so keep the file somewhere like SDL_GetPrefPath().
+ */
+class AudioCalibrationCache
+{
+public:
+    /**
+     * @param fileName  Loaded now if it exists, and rewritten on every store
+     */
+    explicit AudioCalibrationCache(std::string fileName);
+
+    /**
+     * @param deviceName  Device name, or nullptr for the default device
+     * @return Cached buffer size, or 0 if the device has not been calibrated
+     */
+    std::uint16_t find(const char* deviceName) const;
+
+    /**
+     * @throws SdlError if the file can't be written
+     */
+    void store(const char* deviceName, std::uint16_t samples);
+
+    /**
+     * @brief Get the cached buffer size, calibrating and storing it on a miss.
+     * @throws SdlError
+     */
+    std::uint16_t getSamples(const AudioSubsystem&, const char* deviceName, const AudioCalibrationOptions& options = {});
+
+private:
+    void save() const;
+
+    std::string _fileName;
+    std::unordered_map<std::string, std::uint16_t> _samples {};
+};
+
+namespace detail
+{
+
+// times callbacks into preallocated storage, read after the device closes
+struct AudioCalibrationProbe
+{
+    // callbacks ignored while the driver settles
+    static constexpr std::uint32_t WARM_UP_CALLBACKS = 4;
+
+    const AudioCalibrationOptions* options;
+    std::uint64_t frequency;
+    std::uint64_t lastStart;
+    std::uint32_t warmUp;
+    std::vector<std::uint32_t> intervals;
+    std::vector<std::uint32_t> durations;
+    std::atomic<std::size_t> count;
+
+    static void callback(void* userdata, std::uint8_t* stream, int len);
+};
+
+inline void AudioCalibrationProbe::callback(void* userdata, std::uint8_t* stream, int len)
+{
+    AudioCalibrationProbe* probe = reinterpret_cast<AudioCalibrationProbe*>(userdata);
+    std::uint64_t start = SDL_GetPerformanceCounter();
+
+    if(probe->options->load != nullptr) {
+        probe->options->load(probe->options->userdata, stream, len);
+    }
+    std::memset(stream, 0, len);
+
+    std::uint64_t end = SDL_GetPerformanceCounter();
+    std::size_t count = probe->count.load(std::memory_order_relaxed);
+    if(probe->warmUp < WARM_UP_CALLBACKS) {
+        ++probe->warmUp;
+    }
+    else if(count < probe->intervals.size()) {
+        probe->intervals[count] = static_cast<std::uint32_t>((start - probe->lastStart) * 1000000 / probe->frequency);
+        probe->durations[count] = static_cast<std::uint32_t>((end - start) * 1000000 / probe->frequency);
+        probe->count.store(count + 1, std::memory_order_release);
+    }
+    probe->lastStart = start;
+}
+
+inline AudioCalibrationResult measureAudioDevice(const AudioSubsystem& subsystem, const char* name, const AudioCalibrationOptions& options, std::uint16_t samples)
+{
+    AudioCalibrationProbe probe {};
+    probe.options = &options;
+    probe.frequency = SDL_GetPerformanceFrequency();
+
+    AudioCalibrationResult result {};
+    result.samples = samples;
+    {
+        AudioDevice device {subsystem, name, false, options.freq, options.format, options.channels, samples, AudioCalibrationProbe::callback, &probe};
+        const SDL_AudioSpec& spec = device.getObtainedSpec();
+        result.obtainedSamples = spec.samples;
+        result.latencyUs = static_cast<std::uint32_t>(std::uint64_t{spec.samples} * 1000000 / spec.freq);
+
+        // twice the callbacks expected in the window, allocated before the callback can run
+        std::size_t capacity = std::uint64_t{options.windowMs} * spec.freq / (1000 * std::max<std::uint16_t>(spec.samples, 1)) * 2 + 1;
+        probe.intervals.resize(capacity);
+        probe.durations.resize(capacity);
+
+        device.play();
+        SDL_Delay(options.windowMs + result.latencyUs * AudioCalibrationProbe::WARM_UP_CALLBACKS / 1000);
+        device.pause();
+    }
+
+    std::size_t count = probe.count.load(std::memory_order_acquire);
+    std::vector<double> deviations(count);
+    for(std::size_t i = 0; i < count; ++i) {
+        double period = result.latencyUs;
+        deviations[i] = std::abs(probe.intervals[i] - period) / period;
+        if(probe.durations[i] > result.latencyUs || probe.intervals[i] > 2 * result.latencyUs) {
+            ++result.underruns;
+        }
+    }
+
+    if(count == 0) {
+        // the device never called back in time to measure
+        result.jitter = 1.0;
+        ++result.underruns;
+    }
+    else {
+        auto p99 = deviations.begin() + std::min(count - 1, count * 99 / 100);
+        std::nth_element(deviations.begin(), p99, deviations.end());
+        result.jitter = *p99;
+    }
+
+    result.stable = result.jitter <= options.maxJitter && result.underruns <= options.maxUnderruns;
+    return result;
+}
+
+} // namespace detail
+
+inline AudioCalibrationResult calibrateAudioDevice(const AudioSubsystem& subsystem, const char* name, const AudioCalibrationOptions& options)
+{
+    assert(options.minSamples > 0 && options.minSamples <= options.maxSamples);
+
+    AudioCalibrationResult best = detail::measureAudioDevice(subsystem, name, options, options.maxSamples);
+    if(!best.stable) {
+        return best;
+    }
+
+    for(std::uint16_t samples = options.maxSamples / 2; samples >= options.minSamples; samples /= 2) {
+        AudioCalibrationResult result = detail::measureAudioDevice(subsystem, name, options, samples);
+        // a driver which rounds up gains nothing from asking for less
+        if(!result.stable || result.obtainedSamples >= best.obtainedSamples) {
+            break;
+        }
+        best = result;
+    }
+    return best;
+}
+
+inline AudioCalibrationCache::AudioCalibrationCache(std::string fileName)
+    : _fileName(std::move(fileName))
+{
+    std::unique_ptr<SDL_RWops, detail::RWopsDeleter> rw {SDL_RWFromFile(_fileName.c_str(), "rb")};
+    if(!rw) {
+        return;
+    }
+
+    Sint64 size = SDL_RWsize(rw.get());
+    std::string text(static_cast<std::size_t>(std::max<Sint64>(size, 0)), '\0');
+    text.resize(SDL_RWread(rw.get(), &text[0], 1, text.size()));
+
+    // one "samples name" line per device
+    std::size_t begin = 0;
+    while(begin < text.size()) {
+        std::size_t end = std::min(text.find('\n', begin), text.size());
+        std::string line = text.substr(begin, end - begin);
+        std::size_t space = line.find(' ');
+        if(space != std::string::npos) {
+            unsigned long samples = std::strtoul(line.c_str(), nullptr, 10);
+            if(samples > 0 && samples <= 0xFFFF) {
+                _samples[line.substr(space + 1)] = static_cast<std::uint16_t>(samples);
+            }
+        }
+        begin = end + 1;
+    }
+}
+
+inline std::uint16_t AudioCalibrationCache::find(const char* deviceName) const
+{
+    auto found = _samples.find(deviceName != nullptr ? deviceName : "");
+    return found != _samples.end() ? found->second : 0;
+}
+
+inline void AudioCalibrationCache::store(const char* deviceName, std::uint16_t samples)
+{
+    assert(samples > 0);
+    _samples[deviceName != nullptr ? deviceName : ""] = samples;
+    save();
+}
+
+inline std::uint16_t AudioCalibrationCache::getSamples(const AudioSubsystem& subsystem, const char* deviceName, const AudioCalibrationOptions& options)
+{
+    std::uint16_t samples = find(deviceName);
+    if(samples == 0) {
+        samples = calibrateAudioDevice(subsystem, deviceName, options).samples;
+        store(deviceName, samples);
+    }
+    return samples;
+}
+
+inline void AudioCalibrationCache::save() const
+{
+    std::string text;
+    for(const auto& entry : _samples) {
+        text += std::to_string(entry.second) + ' ' + entry.first + '\n';
+    }
+
+    std::unique_ptr<SDL_RWops, detail::RWopsDeleter> rw {SDL_RWFromFile(_fileName.c_str(), "wb")};
+    if(!rw) {
+        throw SdlError{};
+    }
+    if(SDL_RWwrite(rw.get(), text.data(), 1, text.size()) != text.size()) {
+        throw SdlError{};
+    }
+}
+
+} // namespace sdlwrapper
+
+#endif // SDLWRAPPER_AUDIO_CALIBRATION_HPP
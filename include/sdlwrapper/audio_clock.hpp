@@ -0,0 +1,205 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef SDLWRAPPER_AUDIO_CLOCK_HPP
+#define SDLWRAPPER_AUDIO_CLOCK_HPP
+
+#include "sdlwrapper/audio.hpp"
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+namespace sdlwrapper
+{
+
+/**
+ * @brief Monotonic playback position of an output device, for syncing video or gameplay to audio.
+ *
+ * The position counts frames handed to the device, each advance stamped with SDL_GetPerformanceCounter().
+ * Between advances it is interpolated at the sample rate, but never past the frames handed over,
+ * so it is smooth, never runs backwards, and stops when the device pauses or starves.
+ * In callback mode it is exact at the start of every callback. In queue mode it is corrected
+ * at every update(), and interpolates up to the end of the queue.
+ *
+ * One thread advances the clock: the audio thread through callback() in callback mode,
+ * or the producer through addQueued() and update() in queue mode.
+ * Any thread may read it, without locking.
+ */
+class AudioClock
+{
+public:
+    /**
+     * The device must be opened with the same spec, without frequency, format or channel changes.
+     *
+     * @param source  Callback which fills each buffer, in callback mode
+     * @param userdata  Passed to source
+     */
+    AudioClock(int freq, AudioFormat format, std::uint8_t channels, SDL_AudioCallback source = nullptr, void* userdata = nullptr);
+
+    AudioClock(const AudioClock&) = delete;
+    AudioClock& operator=(const AudioClock&) = delete;
+
+    /**
+     * @brief Get the interpolated playback position in frames. Any thread.
+     */
+    std::uint64_t getFrames() const;
+
+    /**
+     * @brief Get the interpolated playback position in seconds. Any thread.
+     */
+    double getSeconds() const;
+
+    /**
+     * @brief Start the next buffer of frames now. Audio thread only, called by callback().
+     */
+    void advance(std::uint32_t frames);
+
+#ifdef SDLWRAPPER_AUDIO_SUPPORTS_NONCALLBACK
+    /**
+     * @brief Count bytes queued to a non-callback device. Producer thread only.
+     */
+    void addQueued(std::uint32_t bytes);
+
+    /**
+     * @brief Advance to the frames drained from a non-callback device's queue. Producer thread only.
+     *
+     * Call after every poll of the queue, the more often the better.
+     * Every byte queued to the device must be counted by addQueued(), and the queue never cleared.
+     */
+    void update(const AudioDevice& device);
+#endif // SDLWRAPPER_AUDIO_SUPPORTS_NONCALLBACK
+
+    /**
+     * @brief Advance the clock, then fill the buffer from source, or with silence.
+     *
+     * Pass as the AudioDevice callback, with the clock as userdata.
+     */
+    static void callback(void* userdata, std::uint8_t* stream, int len);
+
+private:
+    // publish a position of frames at now, which interpolates up to limit
+    void publish(std::uint64_t frames, std::uint64_t limit, std::uint64_t counter);
+
+    int _freq;
+    std::uint32_t _frameSize;
+    std::uint64_t _counterFrequency;
+    SDL_AudioCallback _source;
+    void* _userdata;
+
+    // writer thread state
+    std::uint64_t _queuedFrames {};
+
+    // seqlock, odd while the writer is publishing
+    std::atomic<std::uint32_t> _sequence {};
+    std::atomic<std::uint64_t> _frames {};
+    std::atomic<std::uint64_t> _limit {};
+    std::atomic<std::uint64_t> _counter {};
+};
+
+inline AudioClock::AudioClock(int freq, AudioFormat format, std::uint8_t channels, SDL_AudioCallback source, void* userdata)
+    : _freq(freq),
+      _frameSize(channels * SDL_AUDIO_BITSIZE(format) / 8),
+      _counterFrequency(SDL_GetPerformanceFrequency()),
+      _source(source),
+      _userdata(userdata)
+{
+    assert(freq > 0 && _frameSize > 0);
+}
+
+inline std::uint64_t AudioClock::getFrames() const
+{
+    std::uint64_t frames;
+    std::uint64_t limit;
+    std::uint64_t counter;
+    std::uint32_t sequence;
+    do {
+        sequence = _sequence.load(std::memory_order_acquire);
+        frames = _frames.load(std::memory_order_relaxed);
+        limit = _limit.load(std::memory_order_relaxed);
+        counter = _counter.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while((sequence & 1) != 0 || sequence != _sequence.load(std::memory_order_relaxed));
+
+    if(frames >= limit) {
+        return frames;
+    }
+
+    // split the multiply, so long gaps don't overflow
+    std::uint64_t elapsed = SDL_GetPerformanceCounter() - counter;
+    std::uint64_t seconds = elapsed / _counterFrequency;
+    std::uint64_t played = seconds * _freq + (elapsed - seconds * _counterFrequency) * _freq / _counterFrequency;
+    return std::min(frames + played, limit);
+}
+
+inline double AudioClock::getSeconds() const
+{
+    return static_cast<double>(getFrames()) / _freq;
+}
+
+inline void AudioClock::advance(std::uint32_t frames)
+{
+    std::uint64_t position = _limit.load(std::memory_order_relaxed);
+    publish(position, position + frames, SDL_GetPerformanceCounter());
+}
+
+#ifdef SDLWRAPPER_AUDIO_SUPPORTS_NONCALLBACK
+inline void AudioClock::addQueued(std::uint32_t bytes)
+{
+    _queuedFrames += bytes / _frameSize;
+}
+
+inline void AudioClock::update(const AudioDevice& device)
+{
+    std::uint64_t counter = SDL_GetPerformanceCounter();
+    std::uint64_t drained = _queuedFrames - std::min<std::uint64_t>(device.getQueueSize() / _frameSize, _queuedFrames);
+
+    // the device drains a buffer at a time, so keep any interpolation already read,
+    // and interpolate up to the end of the queue while playing
+    std::uint64_t frames = std::max(drained, getFrames());
+    publish(frames, device.getStatus() == SDL_AUDIO_PLAYING ? std::max(frames, _queuedFrames) : frames, counter);
+}
+#endif // SDLWRAPPER_AUDIO_SUPPORTS_NONCALLBACK
+
+inline void AudioClock::callback(void* userdata, std::uint8_t* stream, int len)
+{
+    AudioClock* clock = reinterpret_cast<AudioClock*>(userdata);
+    clock->advance(static_cast<std::uint32_t>(len) / clock->_frameSize);
+    if(clock->_source != nullptr) {
+        clock->_source(clock->_userdata, stream, len);
+    }
+    else {
+        std::memset(stream, 0, len);
+    }
+}
+
+inline void AudioClock::publish(std::uint64_t frames, std::uint64_t limit, std::uint64_t counter)
+{
+    std::uint32_t sequence = _sequence.load(std::memory_order_relaxed);
+    _sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    _frames.store(frames, std::memory_order_relaxed);
+    _limit.store(limit, std::memory_order_relaxed);
+    _counter.store(counter, std::memory_order_relaxed);
+    _sequence.store(sequence + 2, std::memory_order_release);
+}
+
+} // namespace sdlwrapper
+
+#endif // SDLWRAPPER_AUDIO_CLOCK_HPP
@@ -0,0 +1,285 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef SDLWRAPPER_AUDIO_CONVERT_HPP
+#define SDLWRAPPER_AUDIO_CONVERT_HPP
+
+#include "sdlwrapper/audio.hpp"
+#include "sdlwrapper/sdl_error.hpp"
+#include "sdlwrapper/detail/simd.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+namespace sdlwrapper
+{
+
+namespace detail
+{
+
+// every format which convert() supports, in either byte order
+inline constexpr std::array<AudioFormat, 10> CONVERTIBLE_AUDIO_FORMATS {
+    AUDIO_U8,
+    AUDIO_S8,
+    AUDIO_U16LSB,
+    AUDIO_U16MSB,
+    AUDIO_S16LSB,
+    AUDIO_S16MSB,
+    AUDIO_S32LSB,
+    AUDIO_S32MSB,
+    AUDIO_F32LSB,
+    AUDIO_F32MSB
+};
+
+constexpr bool isConvertibleAudioFormat(AudioFormat format)
+{
+    for(AudioFormat convertible : CONVERTIBLE_AUDIO_FORMATS) {
+        if(convertible == format) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename T>
+T swapSample(T sample)
+{
+    if constexpr(sizeof(T) == 1) {
+        return sample;
+    }
+    else if constexpr(std::is_floating_point_v<T>) {
+        return SDL_SwapFloat(sample);
+    }
+    else if constexpr(sizeof(T) == 2) {
+        return static_cast<T>(SDL_Swap16(static_cast<std::uint16_t>(sample)));
+    }
+    else {
+        return static_cast<T>(SDL_Swap32(static_cast<std::uint32_t>(sample)));
+    }
+}
+
+// integer samples are converted through a signed, left aligned 32 bit value
+template <AudioFormat Format>
+std::int32_t sampleToInt32(typename AudioFormatTraits<Format>::SampleType sample)
+{
+    using Traits = AudioFormatTraits<Format>;
+    constexpr int shift = 32 - Traits::sampleBitSize;
+    if constexpr(Traits::sampleSigned) {
+        return static_cast<std::int32_t>(static_cast<std::uint32_t>(sample) << shift);
+    }
+    else {
+        return static_cast<std::int32_t>((static_cast<std::uint32_t>(sample) << shift) ^ 0x80000000u);
+    }
+}
+
+template <AudioFormat Format>
+typename AudioFormatTraits<Format>::SampleType int32ToSample(std::int32_t value)
+{
+    using Traits = AudioFormatTraits<Format>;
+    using SampleType = typename Traits::SampleType;
+    constexpr int shift = 32 - Traits::sampleBitSize;
+    if constexpr(Traits::sampleSigned) {
+        return static_cast<SampleType>(value >> shift);
+    }
+    else {
+        return static_cast<SampleType>((static_cast<std::uint32_t>(value) ^ 0x80000000u) >> shift);
+    }
+}
+
+template <AudioFormat SrcFormat, AudioFormat DstFormat>
+typename AudioFormatTraits<DstFormat>::SampleType convertSample(typename AudioFormatTraits<SrcFormat>::SampleType sample)
+{
+    using SrcTraits = AudioFormatTraits<SrcFormat>;
+    using DstTraits = AudioFormatTraits<DstFormat>;
+    using DstType = typename DstTraits::SampleType;
+
+    if constexpr(!SrcTraits::sampleNativeEndian) {
+        sample = swapSample(sample);
+    }
+
+    DstType result;
+    if constexpr(SrcTraits::sampleFloating && DstTraits::sampleFloating) {
+        result = sample;
+    }
+    else if constexpr(SrcTraits::sampleFloating) {
+        // truncate toward zero and saturate, like the SIMD paths, with NaN becoming the minimum as in SSE2
+        constexpr float scale = static_cast<float>(1u << (DstTraits::sampleBitSize - 1));
+        constexpr float high = DstTraits::sampleBitSize == 32 ? 2147483520.0f : scale - 1.0f;
+        float scaled = std::min(std::max(-scale, sample * scale), high);
+        result = int32ToSample<DstFormat>(static_cast<std::int32_t>(scaled) * static_cast<std::int32_t>(1u << (32 - DstTraits::sampleBitSize)));
+    }
+    else if constexpr(DstTraits::sampleFloating) {
+        result = static_cast<DstType>(sampleToInt32<SrcFormat>(sample)) * (1.0f / 2147483648.0f);
+    }
+    else {
+        result = int32ToSample<DstFormat>(sampleToInt32<SrcFormat>(sample));
+    }
+
+    if constexpr(!DstTraits::sampleNativeEndian) {
+        result = swapSample(result);
+    }
+    return result;
+}
+
+inline void convertS16ToF32(const std::int16_t* src, float* dst, std::size_t count)
+{
+    std::size_t i = 0;
+#if defined(SDLWRAPPER_SIMD_SSE2)
+    const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+    for(; i + 8 <= count; i += 8) {
+        __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(in, in), 16);
+        __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(in, in), 16);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scale));
+    }
+#elif defined(SDLWRAPPER_SIMD_NEON)
+    const float32x4_t scale = vdupq_n_f32(1.0f / 32768.0f);
+    for(; i + 8 <= count; i += 8) {
+        int16x8_t in = vld1q_s16(src + i);
+        vst1q_f32(dst + i, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(in))), scale));
+        vst1q_f32(dst + i + 4, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(in))), scale));
+    }
+#endif
+    for(; i < count; ++i) {
+        dst[i] = convertSample<AUDIO_S16SYS, AUDIO_F32SYS>(src[i]);
+    }
+}
+
+inline void convertF32ToS16(const float* src, std::int16_t* dst, std::size_t count)
+{
+    std::size_t i = 0;
+#if defined(SDLWRAPPER_SIMD_SSE2)
+    const __m128 scale = _mm_set1_ps(32768.0f);
+    const __m128 lowest = _mm_set1_ps(-32768.0f);
+    const __m128 highest = _mm_set1_ps(32767.0f);
+    for(; i + 8 <= count; i += 8) {
+        // clamp before converting, cvttps gives INT_MIN past the int32 range,
+        // max returns its second operand for NaN
+        __m128 scaledLow = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i), scale), lowest), highest);
+        __m128 scaledHigh = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i + 4), scale), lowest), highest);
+        __m128i low = _mm_cvttps_epi32(scaledLow);
+        __m128i high = _mm_cvttps_epi32(scaledHigh);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packs_epi32(low, high));
+    }
+#elif defined(SDLWRAPPER_SIMD_NEON)
+    const float32x4_t scale = vdupq_n_f32(32768.0f);
+    const float32x4_t lowest = vdupq_n_f32(-32768.0f);
+    const float32x4_t highest = vdupq_n_f32(32767.0f);
+    for(; i + 8 <= count; i += 8) {
+        int32x4_t low = vcvtq_s32_f32(vminq_f32(vmaxq_f32(vmulq_f32(vld1q_f32(src + i), scale), lowest), highest));
+        int32x4_t high = vcvtq_s32_f32(vminq_f32(vmaxq_f32(vmulq_f32(vld1q_f32(src + i + 4), scale), lowest), highest));
+        vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(low), vqmovn_s32(high)));
+    }
+#endif
+    for(; i < count; ++i) {
+        dst[i] = convertSample<AUDIO_F32SYS, AUDIO_S16SYS>(src[i]);
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Convert samples between formats known at compile time.
+ *
+ * Supports U8, S8, U16, S16, S32 and F32, in either byte order.
+ * Integer conversions are exact shifts, float to integer conversions truncate and saturate.
+ * S16 and F32 in native byte order use SSE2 or NEON when available,
+ * the rest are simple loops for the compiler to vectorize.
+ *
+ * @param src  Source samples
+ * @param dst  Destination samples, must not overlap src unless the formats are the same size
+ * @param count  Number of samples (frames * channels)
+ */
+template <AudioFormat SrcFormat, AudioFormat DstFormat>
+void convert(const typename AudioFormatTraits<SrcFormat>::SampleType* src, typename AudioFormatTraits<DstFormat>::SampleType* dst, std::size_t count)
+{
+    static_assert(detail::isConvertibleAudioFormat(SrcFormat), "unsupported source format");
+    static_assert(detail::isConvertibleAudioFormat(DstFormat), "unsupported destination format");
+
+    if constexpr(SrcFormat == DstFormat) {
+        std::memmove(dst, src, count * sizeof(*src));
+    }
+    else if constexpr(SrcFormat == AUDIO_S16SYS && DstFormat == AUDIO_F32SYS) {
+        detail::convertS16ToF32(src, dst, count);
+    }
+    else if constexpr(SrcFormat == AUDIO_F32SYS && DstFormat == AUDIO_S16SYS) {
+        detail::convertF32ToS16(src, dst, count);
+    }
+    else {
+        for(std::size_t i = 0; i < count; ++i) {
+            dst[i] = detail::convertSample<SrcFormat, DstFormat>(src[i]);
+        }
+    }
+}
+
+namespace detail
+{
+
+using ConvertFunction = void(*)(const void* src, void* dst, std::size_t count);
+
+template <AudioFormat SrcFormat, AudioFormat DstFormat>
+void convertUntyped(const void* src, void* dst, std::size_t count)
+{
+    convert<SrcFormat, DstFormat>(
+        static_cast<const typename AudioFormatTraits<SrcFormat>::SampleType*>(src),
+        static_cast<typename AudioFormatTraits<DstFormat>::SampleType*>(dst),
+        count);
+}
+
+template <std::size_t... Indices>
+constexpr auto makeConvertTable(std::index_sequence<Indices...>)
+{
+    constexpr std::size_t n = CONVERTIBLE_AUDIO_FORMATS.size();
+    return std::array<ConvertFunction, sizeof...(Indices)> {
+        &convertUntyped<CONVERTIBLE_AUDIO_FORMATS[Indices / n], CONVERTIBLE_AUDIO_FORMATS[Indices % n]>...
+    };
+}
+
+inline std::size_t getConvertibleAudioFormatIndex(AudioFormat format)
+{
+    auto it = std::find(CONVERTIBLE_AUDIO_FORMATS.begin(), CONVERTIBLE_AUDIO_FORMATS.end(), format);
+    if(it == CONVERTIBLE_AUDIO_FORMATS.end()) {
+        SDL_SetError("Unsupported audio format 0x%x", static_cast<unsigned>(format));
+        throw SdlError{};
+    }
+    return it - CONVERTIBLE_AUDIO_FORMATS.begin();
+}
+
+} // namespace detail
+
+/**
+ * @brief Convert samples between formats known at run time, such as Wav::getAudioFormat().
+ *
+ * Dispatches to convert<SrcFormat, DstFormat>().
+ * @throws SdlError if either format is unsupported
+ */
+inline void convert(AudioFormat srcFormat, AudioFormat dstFormat, const void* src, void* dst, std::size_t count)
+{
+    constexpr std::size_t n = detail::CONVERTIBLE_AUDIO_FORMATS.size();
+    static constexpr auto table = detail::makeConvertTable(std::make_index_sequence<n * n>{});
+
+    std::size_t srcIndex = detail::getConvertibleAudioFormatIndex(srcFormat);
+    std::size_t dstIndex = detail::getConvertibleAudioFormatIndex(dstFormat);
+    table[srcIndex * n + dstIndex](src, dst, count);
+}
+
+} // namespace sdlwrapper
+
+#endif // SDLWRAPPER_AUDIO_CONVERT_HPP
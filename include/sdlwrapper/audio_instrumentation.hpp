@@ -0,0 +1,208 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef SDLWRAPPER_AUDIO_INSTRUMENTATION_HPP
+#define SDLWRAPPER_AUDIO_INSTRUMENTATION_HPP
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+
+namespace sdlwrapper
+{
+
+/**
+ * @brief Lock-free histogram with power of two buckets.
+ *
+ * Bucket 0 counts zeros, and bucket i counts values in [2^(i-1), 2^i).
+ * One thread records, any thread may take snapshots.
+ */
+class AudioHistogram
+{
+public:
+    static constexpr std::size_t NUM_BUCKETS = 33;
+
+    struct Snapshot
+    {
+        std::array<std::uint64_t, NUM_BUCKETS> counts;
+        std::uint64_t total;
+        std::uint64_t max;
+        std::uint64_t sum;
+
+        /**
+         * @brief Get the upper bound of the bucket containing the given fraction of values, at most max.
+         * @param fraction  0.0 to 1.0, for example 0.99 for the 99th percentile
+         */
+        std::uint64_t getPercentile(double fraction) const;
+    };
+
+    void record(std::uint32_t value);
+
+    /**
+     * @brief Copy the current counts. Counters are read one at a time, so totals may be off by concurrent records.
+     */
+    Snapshot getSnapshot() const;
+
+private:
+    std::array<std::atomic<std::uint64_t>, NUM_BUCKETS> _counts {};
+    std::atomic<std::uint64_t> _max {};
+    std::atomic<std::uint64_t> _sum {};
+};
+
+/**
+ * @brief Timing of every audio callback, in microseconds.
+ *
+ * Recorded by AudioDevice when SDLWRAPPER_AUDIO_INSTRUMENTATION is defined.
+ */
+class AudioCallbackStats
+{
+public:
+    struct Snapshot
+    {
+        std::uint64_t callbacks;
+        std::uint64_t missedDeadlines;
+        std::uint32_t deadline;
+
+        // time spent in the callback
+        AudioHistogram::Snapshot durations;
+        // time from the start of one callback to the start of the next
+        AudioHistogram::Snapshot intervals;
+        // time left before the deadline, for callbacks which met it
+        AudioHistogram::Snapshot margins;
+    };
+
+    /**
+     * @brief Set the time one callback's worth of audio lasts, samples / freq.
+     */
+    void setDeadline(std::uint32_t deadlineMicroseconds);
+
+    /**
+     * @brief Record one callback. Audio thread only.
+     * @param start  SDL_GetPerformanceCounter() before the callback
+     * @param end  SDL_GetPerformanceCounter() after the callback
+     */
+    void record(std::uint64_t start, std::uint64_t end);
+
+    Snapshot getSnapshot() const;
+
+private:
+    std::uint32_t toMicroseconds(std::uint64_t counts) const;
+
+    std::uint64_t _frequency {SDL_GetPerformanceFrequency()};
+    std::atomic<std::uint32_t> _deadline {};
+    std::atomic<std::uint64_t> _callbacks {};
+    std::atomic<std::uint64_t> _missedDeadlines {};
+    std::uint64_t _lastStart {};
+
+    AudioHistogram _durations {};
+    AudioHistogram _intervals {};
+    AudioHistogram _margins {};
+};
+
+inline std::uint64_t AudioHistogram::Snapshot::getPercentile(double fraction) const
+{
+    std::uint64_t target = static_cast<std::uint64_t>(fraction * static_cast<double>(total));
+    std::uint64_t seen = 0;
+    for(std::size_t i = 0; i < NUM_BUCKETS; ++i) {
+        seen += counts[i];
+        if(seen > target) {
+            return i == 0 ? 0 : std::min((std::uint64_t{1} << i) - 1, max);
+        }
+    }
+    return max;
+}
+
+inline void AudioHistogram::record(std::uint32_t value)
+{
+    std::size_t bucket = 0;
+    while(bucket < 32 && (value >> bucket) != 0) {
+        ++bucket;
+    }
+    _counts[bucket].fetch_add(1, std::memory_order_relaxed);
+    _sum.fetch_add(value, std::memory_order_relaxed);
+    if(value > _max.load(std::memory_order_relaxed)) {
+        _max.store(value, std::memory_order_relaxed);
+    }
+}
+
+inline AudioHistogram::Snapshot AudioHistogram::getSnapshot() const
+{
+    Snapshot snapshot {};
+    for(std::size_t i = 0; i < NUM_BUCKETS; ++i) {
+        snapshot.counts[i] = _counts[i].load(std::memory_order_relaxed);
+        snapshot.total += snapshot.counts[i];
+    }
+    snapshot.max = _max.load(std::memory_order_relaxed);
+    snapshot.sum = _sum.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+inline void AudioCallbackStats::setDeadline(std::uint32_t deadlineMicroseconds)
+{
+    _deadline.store(deadlineMicroseconds, std::memory_order_relaxed);
+}
+
+inline void AudioCallbackStats::record(std::uint64_t start, std::uint64_t end)
+{
+    std::uint32_t duration = toMicroseconds(end - start);
+    _durations.record(duration);
+
+    if(_lastStart != 0) {
+        _intervals.record(toMicroseconds(start - _lastStart));
+    }
+    _lastStart = start;
+
+    std::uint32_t deadline = _deadline.load(std::memory_order_relaxed);
+    if(duration > deadline) {
+        _missedDeadlines.fetch_add(1, std::memory_order_relaxed);
+    }
+    else {
+        _margins.record(deadline - duration);
+    }
+
+    _callbacks.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline AudioCallbackStats::Snapshot AudioCallbackStats::getSnapshot() const
+{
+    Snapshot snapshot {};
+    snapshot.callbacks = _callbacks.load(std::memory_order_relaxed);
+    snapshot.missedDeadlines = _missedDeadlines.load(std::memory_order_relaxed);
+    snapshot.deadline = _deadline.load(std::memory_order_relaxed);
+    snapshot.durations = _durations.getSnapshot();
+    snapshot.intervals = _intervals.getSnapshot();
+    snapshot.margins = _margins.getSnapshot();
+    return snapshot;
+}
+
+inline std::uint32_t AudioCallbackStats::toMicroseconds(std::uint64_t counts) const
+{
+    // split the multiply, so long pauses don't overflow, and saturate past about 71 minutes
+    constexpr std::uint64_t maxMicroseconds = std::numeric_limits<std::uint32_t>::max();
+    std::uint64_t seconds = counts / _frequency;
+    if(seconds > maxMicroseconds / 1000000) {
+        return static_cast<std::uint32_t>(maxMicroseconds);
+    }
+    std::uint64_t microseconds = seconds * 1000000 + counts % _frequency * 1000000 / _frequency;
+    return static_cast<std::uint32_t>(std::min(microseconds, maxMicroseconds));
+}
+
+} // namespace sdlwrapper
+
+#endif // SDLWRAPPER_AUDIO_INSTRUMENTATION_HPP
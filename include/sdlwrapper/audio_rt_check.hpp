@@ -0,0 +1,304 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef SDLWRAPPER_AUDIO_RT_CHECK_HPP
+#define SDLWRAPPER_AUDIO_RT_CHECK_HPP
+
+// Real-time safety checks for audio callbacks.
+//
+// Define SDLWRAPPER_AUDIO_RT_CHECK to mark the audio thread while an AudioDevice callback runs.
+// Locks taken by sdlwrapper, and any checkAudioRt call, are then reported from inside callbacks.
+//
+// To also report heap allocation, define SDLWRAPPER_AUDIO_RT_CHECK_OPERATOR_NEW
+// before including this header in exactly one translation unit,
+// which replaces the global operator new and delete.
+//
+// Without SDLWRAPPER_AUDIO_RT_CHECK, every check compiles to nothing.
+
+#include <SDL.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+    #include <malloc.h>
+#endif
+
+namespace sdlwrapper
+{
+
+enum class AudioRtViolation
+{
+    ALLOCATION,
+    DEALLOCATION,
+    LOCK
+};
+
+/**
+ * @brief Called on the audio thread for each violation. Checks are suspended while it runs.
+ * @param what  Description of the call site
+ */
+using AudioRtViolationHandler = void (*)(AudioRtViolation violation, const char* what);
+
+/**
+ * @brief Default handler, logs each violation with SDL_LogError.
+ */
+void logAudioRtViolation(AudioRtViolation violation, const char* what);
+
+/**
+ * @brief Handler which logs, then aborts. Useful for enforcing real-time safety in CI.
+ */
+void abortOnAudioRtViolation(AudioRtViolation violation, const char* what);
+
+#ifdef SDLWRAPPER_AUDIO_RT_CHECK
+
+void setAudioRtViolationHandler(AudioRtViolationHandler handler);
+
+/**
+ * @brief Get the number of violations reported so far, on any audio thread.
+ */
+std::uint64_t getAudioRtViolations();
+
+/**
+ * @brief Check if the calling thread is running an AudioDevice callback.
+ */
+bool isAudioThread();
+
+#endif // SDLWRAPPER_AUDIO_RT_CHECK
+
+/**
+ * @brief Report a violation if called from inside an AudioDevice callback.
+ *
+ * Call before taking a lock or making a blocking call that the audio thread must never reach.
+ */
+void checkAudioRt(AudioRtViolation violation, const char* what);
+
+namespace detail
+{
+
+#ifdef SDLWRAPPER_AUDIO_RT_CHECK
+
+struct AudioRtState
+{
+    static inline thread_local bool audioThread {};
+    static inline std::atomic<AudioRtViolationHandler> handler {logAudioRtViolation};
+    static inline std::atomic<std::uint64_t> violations {};
+};
+
+// marks the calling thread as the audio thread, for the scope's lifetime
+class AudioThreadScope
+{
+public:
+    AudioThreadScope()
+        : _previous(AudioRtState::audioThread)
+    {
+        AudioRtState::audioThread = true;
+    }
+
+    AudioThreadScope(const AudioThreadScope&) = delete;
+    AudioThreadScope& operator=(const AudioThreadScope&) = delete;
+
+    ~AudioThreadScope()
+    {
+        AudioRtState::audioThread = _previous;
+    }
+
+private:
+    bool _previous;
+};
+
+#endif // SDLWRAPPER_AUDIO_RT_CHECK
+
+inline const char* getAudioRtViolationName(AudioRtViolation violation)
+{
+    switch(violation) {
+    case AudioRtViolation::ALLOCATION:
+        return "allocation";
+    case AudioRtViolation::DEALLOCATION:
+        return "deallocation";
+    case AudioRtViolation::LOCK:
+        return "lock";
+    }
+    return "unknown";
+}
+
+} // namespace detail
+
+inline void logAudioRtViolation(AudioRtViolation violation, const char* what)
+{
+    SDL_LogError(SDL_LOG_CATEGORY_AUDIO, "real-time violation in audio callback: %s in %s", detail::getAudioRtViolationName(violation), what);
+}
+
+inline void abortOnAudioRtViolation(AudioRtViolation violation, const char* what)
+{
+    logAudioRtViolation(violation, what);
+    std::abort();
+}
+
+#ifdef SDLWRAPPER_AUDIO_RT_CHECK
+
+inline void setAudioRtViolationHandler(AudioRtViolationHandler handler)
+{
+    detail::AudioRtState::handler.store(handler != nullptr ? handler : logAudioRtViolation);
+}
+
+inline std::uint64_t getAudioRtViolations()
+{
+    return detail::AudioRtState::violations.load(std::memory_order_relaxed);
+}
+
+inline bool isAudioThread()
+{
+    return detail::AudioRtState::audioThread;
+}
+
+inline void checkAudioRt(AudioRtViolation violation, const char* what)
+{
+    if(!detail::AudioRtState::audioThread) {
+        return;
+    }
+    // the handler may allocate, for example to log
+    detail::AudioRtState::audioThread = false;
+    detail::AudioRtState::violations.fetch_add(1, std::memory_order_relaxed);
+    detail::AudioRtState::handler.load()(violation, what);
+    detail::AudioRtState::audioThread = true;
+}
+
+#else
+
+inline void checkAudioRt(AudioRtViolation, const char*)
+{
+}
+
+#endif // SDLWRAPPER_AUDIO_RT_CHECK
+
+} // namespace sdlwrapper
+
+#if defined(SDLWRAPPER_AUDIO_RT_CHECK) && defined(SDLWRAPPER_AUDIO_RT_CHECK_OPERATOR_NEW)
+
+// replacements may not be inline, so these are defined in the one translation unit which asks for them
+
+void* operator new(std::size_t size)
+{
+    sdlwrapper::checkAudioRt(sdlwrapper::AudioRtViolation::ALLOCATION, "operator new");
+    if(void* p = std::malloc(size != 0 ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    sdlwrapper::checkAudioRt(sdlwrapper::AudioRtViolation::ALLOCATION, "operator new");
+    return std::malloc(size != 0 ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept
+{
+    if(p != nullptr) {
+        sdlwrapper::checkAudioRt(sdlwrapper::AudioRtViolation::DEALLOCATION, "operator delete");
+    }
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    operator delete(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    operator delete(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    operator delete(p);
+}
+
+// over-aligned types, such as those with cache line aligned members
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    sdlwrapper::checkAudioRt(sdlwrapper::AudioRtViolation::ALLOCATION, "operator new");
+    std::size_t align = static_cast<std::size_t>(alignment);
+#ifdef _WIN32
+    return _aligned_malloc(size != 0 ? size : 1, align);
+#else
+    void* p = nullptr;
+    return posix_memalign(&p, align, size != 0 ? size : 1) == 0 ? p : nullptr;
+#endif
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t& tag) noexcept
+{
+    return operator new(size, alignment, tag);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    if(void* p = operator new(size, alignment, std::nothrow)) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+    if(p != nullptr) {
+        sdlwrapper::checkAudioRt(sdlwrapper::AudioRtViolation::DEALLOCATION, "operator delete");
+    }
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void operator delete[](void* p, std::align_val_t alignment) noexcept
+{
+    operator delete(p, alignment);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t alignment) noexcept
+{
+    operator delete(p, alignment);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t alignment) noexcept
+{
+    operator delete(p, alignment);
+}
+
+#endif // SDLWRAPPER_AUDIO_RT_CHECK && SDLWRAPPER_AUDIO_RT_CHECK_OPERATOR_NEW
+
+#endif // SDLWRAPPER_AUDIO_RT_CHECK_HPP
@@ -0,0 +1,335 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef SDLWRAPPER_AXIS_PROCESSOR_HPP
+#define SDLWRAPPER_AXIS_PROCESSOR_HPP
+
+#include "sdlwrapper/game_controller.hpp"
+#include "sdlwrapper/detail/simd.hpp"
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace sdlwrapper
+{
+
+/**
+ * @brief Response curve from deflection past the deadzone, 0 to 1, to output, usually also 0 to 1.
+ *
+ * Curves should map 0 to 0, so that the deadzone reads as rest.
+ */
+class AxisCurve
+{
+public:
+    // points in a table curve, evenly spaced from 0 to 1
+    static constexpr std::size_t TABLE_POINTS = 65;
+
+    /**
+     * @brief Output equals input.
+     */
+    AxisCurve() = default;
+
+    /**
+     * @brief a * x + b * x^2 + c * x^3, evaluated without leaving SIMD registers.
+     */
+    static AxisCurve polynomial(float a, float b, float c);
+
+    /**
+     * @brief Linear interpolation between values evenly spaced from 0 to 1, resampled to TABLE_POINTS.
+     * @param count  At least 2
+     */
+    static AxisCurve table(const float* values, std::size_t count);
+
+    float evaluate(float x) const;
+
+    detail::Float4 evaluate(detail::Float4 x) const;
+
+private:
+    bool _isTable {};
+    std::array<float, 3> _coefficients {{1.0f, 0.0f, 0.0f}};
+    std::array<float, TABLE_POINTS> _table {};
+};
+
+enum class DeadzoneShape
+{
+    // each axis is clamped on its own, which snaps sticks to the axes near rest
+    AXIAL,
+    // the stick's distance from center is clamped, so its direction is kept
+    RADIAL
+};
+
+struct AxisSettings
+{
+    // triggers always use AXIAL
+    DeadzoneShape shape = DeadzoneShape::RADIAL;
+    // deflection, from 0 to 1, below which the axis reads 0
+    float innerDeadzone = 0.0f;
+    // deflection, from 0 to 1, above which the axis reads as fully deflected
+    float outerDeadzone = 1.0f;
+    AxisCurve curve {};
+};
+
+/**
+ * @brief Normalizes, deadzones and curves every axis of many controllers in one pass.
+ *
+ * Raw axes are transposed into one array per axis, then processed four controllers at a time.
+ * The output is one array of floats per axis, indexed by controller:
+ * sticks from -1 to 1, and triggers from 0 to 1.
+ */
+class AxisProcessor
+{
+public:
+    /**
+     * @param capacity  Controllers processed at once before the arrays need to grow
+     */
+    explicit AxisProcessor(const AxisSettings& sticks = {}, const AxisSettings& triggers = {}, std::size_t capacity = 16);
+
+    void setSticks(const AxisSettings& settings);
+
+    void setTriggers(const AxisSettings& settings);
+
+    /**
+     * @brief Process every axis of count controllers, for example GameControllerManager::getStates().
+     */
+    void process(const GameControllerState* states, std::size_t count);
+
+    /**
+     * @brief Get the number of controllers in the last process.
+     */
+    std::size_t getCount() const;
+
+    /**
+     * @brief Get the processed values of one axis, one per controller.
+     */
+    const float* get(GameController::Axis axis) const;
+
+    float get(GameController::Axis axis, std::size_t controller) const;
+
+private:
+    struct Shape
+    {
+        float inner;
+        float scale;
+    };
+
+    static Shape makeShape(const AxisSettings& settings);
+    static detail::Float4 respond(detail::Float4 magnitude, const Shape& shape, const AxisCurve& curve);
+
+    void processRadial(float* x, float* y) const;
+    void processAxial(float* values, const AxisSettings& settings, const Shape& shape, float low) const;
+
+    AxisSettings _sticks;
+    AxisSettings _triggers;
+    Shape _stickShape;
+    Shape _triggerShape;
+
+    std::size_t _count {};
+    // rounded up to a multiple of Float4::SIZE
+    std::size_t _stride {};
+    std::vector<float> _values {};
+};
+
+inline AxisCurve AxisCurve::polynomial(float a, float b, float c)
+{
+    AxisCurve curve;
+    curve._coefficients = {{a, b, c}};
+    return curve;
+}
+
+inline AxisCurve AxisCurve::table(const float* values, std::size_t count)
+{
+    assert(count >= 2);
+
+    AxisCurve curve;
+    curve._isTable = true;
+    for(std::size_t i = 0; i < TABLE_POINTS; ++i) {
+        float position = static_cast<float>(i) * (count - 1) / (TABLE_POINTS - 1);
+        std::size_t index = std::min(static_cast<std::size_t>(position), count - 2);
+        float fraction = position - index;
+        curve._table[i] = values[index] + (values[index + 1] - values[index]) * fraction;
+    }
+    return curve;
+}
+
+inline float AxisCurve::evaluate(float x) const
+{
+    x = std::min(std::max(x, 0.0f), 1.0f);
+    if(_isTable) {
+        float position = x * (TABLE_POINTS - 1);
+        std::size_t index = std::min(static_cast<std::size_t>(position), TABLE_POINTS - 2);
+        float fraction = position - index;
+        return _table[index] + (_table[index + 1] - _table[index]) * fraction;
+    }
+    // Horner's method
+    return ((_coefficients[2] * x + _coefficients[1]) * x + _coefficients[0]) * x;
+}
+
+inline detail::Float4 AxisCurve::evaluate(detail::Float4 x) const
+{
+    using detail::Float4;
+
+    if(_isTable) {
+        // SSE2 and NEON can't gather, so look up each lane on its own
+        float lanes[Float4::SIZE];
+        x.store(lanes);
+        for(float& lane : lanes) {
+            lane = evaluate(lane);
+        }
+        return Float4::load(lanes);
+    }
+    Float4 result = Float4::splat(_coefficients[2]) * x + Float4::splat(_coefficients[1]);
+    result = result * x + Float4::splat(_coefficients[0]);
+    return result * x;
+}
+
+inline AxisProcessor::AxisProcessor(const AxisSettings& sticks, const AxisSettings& triggers, std::size_t capacity)
+    : _sticks(sticks),
+      _triggers(triggers),
+      _stickShape(makeShape(sticks)),
+      _triggerShape(makeShape(triggers)),
+      _values(GameController::ALL_AXES.size() * ((capacity + detail::Float4::SIZE - 1) / detail::Float4::SIZE * detail::Float4::SIZE))
+{
+}
+
+inline void AxisProcessor::setSticks(const AxisSettings& settings)
+{
+    _sticks = settings;
+    _stickShape = makeShape(settings);
+}
+
+inline void AxisProcessor::setTriggers(const AxisSettings& settings)
+{
+    _triggers = settings;
+    _triggerShape = makeShape(settings);
+}
+
+inline void AxisProcessor::process(const GameControllerState* states, std::size_t count)
+{
+    _count = count;
+    _stride = (count + detail::Float4::SIZE - 1) / detail::Float4::SIZE * detail::Float4::SIZE;
+    if(_values.size() < GameController::ALL_AXES.size() * _stride) {
+        _values.resize(GameController::ALL_AXES.size() * _stride);
+    }
+
+    // transpose into one array per axis, padding the last vector with rest
+    for(std::size_t axis = 0; axis < GameController::ALL_AXES.size(); ++axis) {
+        float* values = _values.data() + axis * _stride;
+        for(std::size_t i = 0; i < count; ++i) {
+            values[i] = states[i].axes[axis];
+        }
+        std::fill(values + count, values + _stride, 0.0f);
+    }
+
+    float* leftX = _values.data() + SDL_CONTROLLER_AXIS_LEFTX * _stride;
+    float* leftY = _values.data() + SDL_CONTROLLER_AXIS_LEFTY * _stride;
+    float* rightX = _values.data() + SDL_CONTROLLER_AXIS_RIGHTX * _stride;
+    float* rightY = _values.data() + SDL_CONTROLLER_AXIS_RIGHTY * _stride;
+    if(_sticks.shape == DeadzoneShape::RADIAL) {
+        processRadial(leftX, leftY);
+        processRadial(rightX, rightY);
+    }
+    else {
+        processAxial(leftX, _sticks, _stickShape, -1.0f);
+        processAxial(leftY, _sticks, _stickShape, -1.0f);
+        processAxial(rightX, _sticks, _stickShape, -1.0f);
+        processAxial(rightY, _sticks, _stickShape, -1.0f);
+    }
+    processAxial(_values.data() + SDL_CONTROLLER_AXIS_TRIGGERLEFT * _stride, _triggers, _triggerShape, 0.0f);
+    processAxial(_values.data() + SDL_CONTROLLER_AXIS_TRIGGERRIGHT * _stride, _triggers, _triggerShape, 0.0f);
+}
+
+inline std::size_t AxisProcessor::getCount() const
+{
+    return _count;
+}
+
+inline const float* AxisProcessor::get(GameController::Axis axis) const
+{
+    assert(axis > GameController::Axis::INVALID && axis < GameController::Axis::MAX);
+    return _values.data() + static_cast<std::size_t>(axis) * _stride;
+}
+
+inline float AxisProcessor::get(GameController::Axis axis, std::size_t controller) const
+{
+    assert(controller < _count);
+    return get(axis)[controller];
+}
+
+inline AxisProcessor::Shape AxisProcessor::makeShape(const AxisSettings& settings)
+{
+    assert(settings.innerDeadzone >= 0.0f && settings.innerDeadzone < settings.outerDeadzone);
+    return {settings.innerDeadzone, 1.0f / (settings.outerDeadzone - settings.innerDeadzone)};
+}
+
+// output magnitude for a normalized input magnitude
+inline detail::Float4 AxisProcessor::respond(detail::Float4 magnitude, const Shape& shape, const AxisCurve& curve)
+{
+    using detail::Float4;
+    Float4 deflection = (magnitude - Float4::splat(shape.inner)) * Float4::splat(shape.scale);
+    deflection = min(max(deflection, Float4::splat(0.0f)), Float4::splat(1.0f));
+    return curve.evaluate(deflection);
+}
+
+inline void AxisProcessor::processRadial(float* x, float* y) const
+{
+    using detail::Float4;
+
+    // same as detail::normalizeAxis, clamping -32768 to -1
+    const Float4 normalize = Float4::splat(1.0f / 32767.0f);
+    const Float4 one = Float4::splat(1.0f);
+    const Float4 minusOne = Float4::splat(-1.0f);
+    // stops 0 / 0 at rest, where the response is 0 anyway
+    const Float4 epsilon = Float4::splat(1e-6f);
+
+    for(std::size_t i = 0; i < _stride; i += Float4::SIZE) {
+        Float4 vx = max(Float4::load(x + i) * normalize, minusOne);
+        Float4 vy = max(Float4::load(y + i) * normalize, minusOne);
+
+        Float4 magnitude = sqrt(vx * vx + vy * vy);
+        Float4 scale = respond(magnitude, _stickShape, _sticks.curve) / max(magnitude, epsilon);
+
+        min(max(vx * scale, minusOne), one).store(x + i);
+        min(max(vy * scale, minusOne), one).store(y + i);
+    }
+}
+
+inline void AxisProcessor::processAxial(float* values, const AxisSettings& settings, const Shape& shape, float low) const
+{
+    using detail::Float4;
+
+    const Float4 normalize = Float4::splat(1.0f / 32767.0f);
+    const Float4 zero = Float4::splat(0.0f);
+    const Float4 one = Float4::splat(1.0f);
+    const Float4 lowest = Float4::splat(low);
+    const Float4 epsilon = Float4::splat(1e-6f);
+
+    for(std::size_t i = 0; i < _stride; i += Float4::SIZE) {
+        Float4 v = max(Float4::load(values + i) * normalize, lowest);
+
+        Float4 magnitude = max(v, zero - v);
+        Float4 scale = respond(magnitude, shape, settings.curve) / max(magnitude, epsilon);
+
+        min(max(v * scale, lowest), one).store(values + i);
+    }
+}
+
+} // namespace sdlwrapper
+
+#endif // SDLWRAPPER_AXIS_PROCESSOR_HPP
@@ -0,0 +1,295 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef SDLWRAPPER_CAPTURE_PIPELINE_HPP
+#define SDLWRAPPER_CAPTURE_PIPELINE_HPP
+
+#include "sdlwrapper/detail/spsc_ring_buffer.hpp"
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace sdlwrapper
+{
+
+/**
+ * @brief Hands recorded audio from a capture device's callback to a consumer thread in fixed-size blocks.
+ *
+ * Every block is allocated up front. The audio thread copies each callback's samples
+ * into the current free block, and queues it once full. The consumer pops full blocks
+ * and reads them in place, and each block returns to the pool when its handle is destroyed.
+ * When no block is free, the audio thread drops the samples and counts an overrun.
+ *
+ * Open the capture device with callback and the CapturePipeline as userdata.
+ * One consumer thread may call pop and flush, and must destroy every Block it pops.
+ */
+class CapturePipeline
+{
+public:
+    /**
+     * @brief Handle to a full block, returns the block to the pool when destroyed.
+     */
+    class Block
+    {
+    public:
+        Block() = default;
+
+        Block(Block&& other);
+        Block& operator=(Block&& other);
+
+        Block(const Block&) = delete;
+        Block& operator=(const Block&) = delete;
+
+        ~Block();
+
+        /**
+         * @brief Check if this handle holds a block.
+         */
+        explicit operator bool() const;
+
+        const std::uint8_t* getData() const;
+
+        /**
+         * @brief Get the number of bytes recorded, the block size unless flushed early.
+         */
+        std::uint32_t getSize() const;
+
+        /**
+         * @brief Return the block to the pool now.
+         */
+        void release();
+
+    private:
+        friend class CapturePipeline;
+
+        Block(CapturePipeline* pipeline, std::uint32_t index);
+
+        CapturePipeline* _pipeline {};
+        std::uint32_t _index {};
+    };
+
+    /**
+     * @param blockSizeBytes  Size of each block, a multiple of the device frame size keeps frames whole
+     * @param numBlocks  Number of blocks in the pool
+     */
+    CapturePipeline(std::uint32_t blockSizeBytes, std::size_t numBlocks);
+
+    CapturePipeline(const CapturePipeline&) = delete;
+    CapturePipeline& operator=(const CapturePipeline&) = delete;
+
+    /**
+     * @brief Take the oldest full block. Consumer only, never blocks.
+     * @return Block, or an empty handle if no block is full yet
+     */
+    Block pop();
+
+    /**
+     * @brief Queue the partly filled block, for example at the end of a recording.
+     *
+     * Consumer only, while the device is paused or locked, so the callback is not running.
+     */
+    void flush();
+
+    /**
+     * @brief Get the number of callbacks which dropped samples because no block was free.
+     */
+    std::uint64_t getOverruns() const;
+
+    /**
+     * @brief Get the total number of bytes dropped by overruns.
+     */
+    std::uint64_t getDroppedBytes() const;
+
+    std::uint32_t getBlockSize() const;
+
+    std::size_t getNumBlocks() const;
+
+    /**
+     * @brief SDL_AudioCallback for a capture AudioDevice, pass the CapturePipeline as userdata.
+     */
+    static void callback(void* userdata, std::uint8_t* stream, int len);
+
+private:
+    static constexpr std::uint32_t NO_BLOCK = ~std::uint32_t{};
+
+    void write(const std::uint8_t* data, std::uint32_t len);
+    void queueCurrent();
+
+    std::uint32_t _blockSize;
+    std::unique_ptr<std::uint8_t[]> _data;
+    // bytes recorded in each block, written before the block is queued
+    std::vector<std::uint32_t> _sizes;
+
+    // block indices, both sized to hold every block so pushes never fail
+    detail::SpscRingBuffer<std::uint32_t> _free;
+    detail::SpscRingBuffer<std::uint32_t> _full;
+
+    // audio thread state
+    std::uint32_t _current {NO_BLOCK};
+    std::uint32_t _fill {};
+
+    std::atomic<std::uint64_t> _overruns {};
+    std::atomic<std::uint64_t> _droppedBytes {};
+};
+
+inline CapturePipeline::Block::Block(CapturePipeline* pipeline, std::uint32_t index)
+    : _pipeline(pipeline),
+      _index(index)
+{
+}
+
+inline CapturePipeline::Block::Block(Block&& other)
+    : _pipeline(std::exchange(other._pipeline, nullptr)),
+      _index(other._index)
+{
+}
+
+inline CapturePipeline::Block& CapturePipeline::Block::operator=(Block&& other)
+{
+    if(this != &other) {
+        release();
+        _pipeline = std::exchange(other._pipeline, nullptr);
+        _index = other._index;
+    }
+    return *this;
+}
+
+inline CapturePipeline::Block::~Block()
+{
+    release();
+}
+
+inline CapturePipeline::Block::operator bool() const
+{
+    return _pipeline != nullptr;
+}
+
+inline const std::uint8_t* CapturePipeline::Block::getData() const
+{
+    assert(_pipeline);
+    return _pipeline->_data.get() + static_cast<std::size_t>(_index) * _pipeline->_blockSize;
+}
+
+inline std::uint32_t CapturePipeline::Block::getSize() const
+{
+    assert(_pipeline);
+    return _pipeline->_sizes[_index];
+}
+
+inline void CapturePipeline::Block::release()
+{
+    if(_pipeline != nullptr) {
+        _pipeline->_free.push(_index);
+        _pipeline = nullptr;
+    }
+}
+
+inline CapturePipeline::CapturePipeline(std::uint32_t blockSizeBytes, std::size_t numBlocks)
+    : _blockSize(blockSizeBytes),
+      _data(new std::uint8_t[static_cast<std::size_t>(blockSizeBytes) * numBlocks]),
+      _sizes(numBlocks),
+      _free(numBlocks),
+      _full(numBlocks)
+{
+    assert(blockSizeBytes > 0 && numBlocks > 0 && numBlocks < NO_BLOCK);
+
+    for(std::uint32_t i = 0; i < numBlocks; ++i) {
+        _free.push(i);
+    }
+}
+
+inline CapturePipeline::Block CapturePipeline::pop()
+{
+    std::uint32_t index;
+    if(!_full.pop(index)) {
+        return {};
+    }
+    return {this, index};
+}
+
+inline void CapturePipeline::flush()
+{
+    if(_current != NO_BLOCK && _fill > 0) {
+        queueCurrent();
+    }
+}
+
+inline std::uint64_t CapturePipeline::getOverruns() const
+{
+    return _overruns.load(std::memory_order_relaxed);
+}
+
+inline std::uint64_t CapturePipeline::getDroppedBytes() const
+{
+    return _droppedBytes.load(std::memory_order_relaxed);
+}
+
+inline std::uint32_t CapturePipeline::getBlockSize() const
+{
+    return _blockSize;
+}
+
+inline std::size_t CapturePipeline::getNumBlocks() const
+{
+    return _sizes.size();
+}
+
+inline void CapturePipeline::callback(void* userdata, std::uint8_t* stream, int len)
+{
+    reinterpret_cast<CapturePipeline*>(userdata)->write(stream, static_cast<std::uint32_t>(len));
+}
+
+inline void CapturePipeline::write(const std::uint8_t* data, std::uint32_t len)
+{
+    while(len > 0) {
+        if(_current == NO_BLOCK) {
+            if(!_free.pop(_current)) {
+                _overruns.fetch_add(1, std::memory_order_relaxed);
+                _droppedBytes.fetch_add(len, std::memory_order_relaxed);
+                return;
+            }
+            _fill = 0;
+        }
+
+        std::uint32_t n = std::min(len, _blockSize - _fill);
+        std::memcpy(_data.get() + static_cast<std::size_t>(_current) * _blockSize + _fill, data, n);
+        _fill += n;
+        data += n;
+        len -= n;
+
+        if(_fill == _blockSize) {
+            queueCurrent();
+        }
+    }
+}
+
+inline void CapturePipeline::queueCurrent()
+{
+    _sizes[_current] = _fill;
+    _full.push(_current);
+    _current = NO_BLOCK;
+}
+
+} // namespace sdlwrapper
+
+#endif // SDLWRAPPER_CAPTURE_PIPELINE_HPP
@@ -17,6 +17,7 @@
 #define SDLWRAPPER_DETAIL_AUDIO_SAMPLE_TYPE_HPP
 
 #include <climits>
+#include <type_traits>
 
 #include <boost/integer.hpp>
 
@@ -77,6 +78,18 @@ struct AudioSampleTypeStruct<false, bits, true>
     using Type = typename boost::int_t<bits>::exact;
 };
 
+// silent value of a sample, as stored in memory
+template <typename T>
+constexpr T audioSampleSilence(bool nativeEndian)
+{
+    if constexpr(std::is_integral_v<T> && std::is_unsigned_v<T>) {
+        return nativeEndian ? static_cast<T>(T{1} << (sizeof(T) * CHAR_BIT - 1)) : static_cast<T>(0x80);
+    }
+    else {
+        return T{};
+    }
+}
+
 } // namespace detail
 } // namespace sdlwrapper
 
@@ -0,0 +1,153 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef SDLWRAPPER_DETAIL_MAPPED_FILE_HPP
+#define SDLWRAPPER_DETAIL_MAPPED_FILE_HPP
+
+#include "sdlwrapper/sdl_error.hpp"
+
+#include <SDL.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef _WIN32
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace sdlwrapper
+{
+namespace detail
+{
+
+/**
+ * @brief Private copy-on-write mapping of a whole file.
+ *
+ * Pages are loaded on first access, and shared with every other process
+ * mapping the same file until written.
+ */
+class MappedFile
+{
+public:
+    /**
+     * @throws SdlError
+     */
+    explicit MappedFile(const char* fileName);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile();
+
+    std::uint8_t* getData() const;
+
+    std::size_t getSize() const;
+
+private:
+    std::uint8_t* _data {};
+    std::size_t _size {};
+};
+
+#ifdef _WIN32
+
+inline MappedFile::MappedFile(const char* fileName)
+{
+    HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file == INVALID_HANDLE_VALUE) {
+        SDL_SetError("Couldn't open %s", fileName);
+        throw SdlError{};
+    }
+
+    LARGE_INTEGER size;
+    HANDLE mapping = nullptr;
+    if(GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+        mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    }
+    CloseHandle(file);
+    if(mapping == nullptr) {
+        SDL_SetError("Couldn't map %s", fileName);
+        throw SdlError{};
+    }
+
+    // the view keeps the mapping alive
+    _data = static_cast<std::uint8_t*>(MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0));
+    CloseHandle(mapping);
+    if(_data == nullptr) {
+        SDL_SetError("Couldn't map %s", fileName);
+        throw SdlError{};
+    }
+    _size = static_cast<std::size_t>(size.QuadPart);
+}
+
+inline MappedFile::~MappedFile()
+{
+    UnmapViewOfFile(_data);
+}
+
+#else
+
+inline MappedFile::MappedFile(const char* fileName)
+{
+    int fd = open(fileName, O_RDONLY);
+    if(fd < 0) {
+        SDL_SetError("Couldn't open %s", fileName);
+        throw SdlError{};
+    }
+
+    struct stat status;
+    void* data = MAP_FAILED;
+    if(fstat(fd, &status) == 0 && status.st_size > 0) {
+        data = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    }
+    // the mapping keeps the file open
+    close(fd);
+    if(data == MAP_FAILED) {
+        SDL_SetError("Couldn't map %s", fileName);
+        throw SdlError{};
+    }
+
+    _data = static_cast<std::uint8_t*>(data);
+    _size = static_cast<std::size_t>(status.st_size);
+}
+
+inline MappedFile::~MappedFile()
+{
+    munmap(_data, _size);
+}
+
+#endif // _WIN32
+
+inline std::uint8_t* MappedFile::getData() const
+{
+    return _data;
+}
+
+inline std::size_t MappedFile::getSize() const
+{
+    return _size;
+}
+
+} // namespace detail
+} // namespace sdlwrapper
+
+#endif // SDLWRAPPER_DETAIL_MAPPED_FILE_HPP
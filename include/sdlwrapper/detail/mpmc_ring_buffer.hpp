@@ -0,0 +1,156 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef SDLWRAPPER_DETAIL_MPMC_RING_BUFFER_HPP
+#define SDLWRAPPER_DETAIL_MPMC_RING_BUFFER_HPP
+
+#include "sdlwrapper/detail/spsc_ring_buffer.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+namespace sdlwrapper
+{
+namespace detail
+{
+
+/**
+ * @brief Lock-free multiple producer, multiple consumer ring buffer.
+ *
+ * Any thread may push or pop. Each cell carries a sequence number,
+ * so a stalled thread only delays the cell it claimed, never the whole buffer.
+ * The capacity is rounded up to a power of two, and never reallocates.
+ */
+template <typename T>
+class MpmcRingBuffer
+{
+    static_assert(std::is_trivially_copyable_v<T>, "MpmcRingBuffer elements are copied without synchronization");
+
+public:
+    explicit MpmcRingBuffer(std::size_t capacity);
+
+    MpmcRingBuffer(const MpmcRingBuffer&) = delete;
+    MpmcRingBuffer& operator=(const MpmcRingBuffer&) = delete;
+
+    std::size_t getCapacity() const;
+
+    /**
+     * @brief Write a single element.
+     * @return false if the buffer is full
+     */
+    bool push(const T& value);
+
+    /**
+     * @brief Read a single element.
+     * @return false if the buffer is empty
+     */
+    bool pop(T& value);
+
+private:
+    struct Cell
+    {
+        // position + 1 once written, position + capacity once read
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> _cells;
+    std::size_t _mask;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> _head {}; // claimed by producers
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> _tail {}; // claimed by consumers
+};
+
+template <typename T>
+MpmcRingBuffer<T>::MpmcRingBuffer(std::size_t capacity)
+    : _cells(new Cell[nextPowerOfTwo(capacity)]),
+      _mask(nextPowerOfTwo(capacity) - 1)
+{
+    assert(capacity > 0);
+    for(std::size_t i = 0; i <= _mask; ++i) {
+        _cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+template <typename T>
+std::size_t MpmcRingBuffer<T>::getCapacity() const
+{
+    return _mask + 1;
+}
+
+template <typename T>
+bool MpmcRingBuffer<T>::push(const T& value)
+{
+    std::size_t position = _head.load(std::memory_order_relaxed);
+    Cell* cell;
+    while(true) {
+        cell = &_cells[position & _mask];
+        std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        std::intptr_t diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+        if(diff == 0) {
+            if(_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        else if(diff < 0) {
+            // the cell still holds an element from the previous lap
+            return false;
+        }
+        else {
+            position = _head.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->value = value;
+    cell->sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+bool MpmcRingBuffer<T>::pop(T& value)
+{
+    std::size_t position = _tail.load(std::memory_order_relaxed);
+    Cell* cell;
+    while(true) {
+        cell = &_cells[position & _mask];
+        std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        std::intptr_t diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position + 1);
+        if(diff == 0) {
+            if(_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        else if(diff < 0) {
+            // the cell hasn't been written this lap
+            return false;
+        }
+        else {
+            position = _tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    value = cell->value;
+    cell->sequence.store(position + _mask + 1, std::memory_order_release);
+    return true;
+}
+
+} // namespace detail
+} // namespace sdlwrapper
+
+#endif // SDLWRAPPER_DETAIL_MPMC_RING_BUFFER_HPP
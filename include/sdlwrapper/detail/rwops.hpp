@@ -0,0 +1,37 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef SDLWRAPPER_DETAIL_RWOPS_HPP
+#define SDLWRAPPER_DETAIL_RWOPS_HPP
+
+#include <SDL.h>
+
+namespace sdlwrapper
+{
+namespace detail
+{
+
+struct RWopsDeleter
+{
+    void operator()(SDL_RWops* rw)
+    {
+        SDL_RWclose(rw);
+    }
+};
+
+} // namespace detail
+} // namespace sdlwrapper
+
+#endif // SDLWRAPPER_DETAIL_RWOPS_HPP
@@ -0,0 +1,163 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef SDLWRAPPER_DETAIL_SIMD_HPP
+#define SDLWRAPPER_DETAIL_SIMD_HPP
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define SDLWRAPPER_SIMD_SSE2
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define SDLWRAPPER_SIMD_NEON
+    #include <arm_neon.h>
+#endif
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace sdlwrapper
+{
+namespace detail
+{
+
+// four packed floats, using SSE2 or NEON when available
+struct Float4
+{
+#if defined(SDLWRAPPER_SIMD_SSE2)
+    __m128 v;
+#elif defined(SDLWRAPPER_SIMD_NEON)
+    float32x4_t v;
+#else
+    float v[4];
+#endif
+
+    static constexpr int SIZE = 4;
+
+    static Float4 load(const float* p);
+    static Float4 splat(float f);
+    void store(float* p) const;
+};
+
+#if defined(SDLWRAPPER_SIMD_SSE2)
+
+inline Float4 Float4::load(const float* p) { return {_mm_loadu_ps(p)}; }
+inline Float4 Float4::splat(float f) { return {_mm_set1_ps(f)}; }
+inline void Float4::store(float* p) const { _mm_storeu_ps(p, v); }
+
+inline Float4 operator+(Float4 a, Float4 b) { return {_mm_add_ps(a.v, b.v)}; }
+inline Float4 operator-(Float4 a, Float4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline Float4 operator*(Float4 a, Float4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+inline Float4 operator/(Float4 a, Float4 b) { return {_mm_div_ps(a.v, b.v)}; }
+inline Float4 min(Float4 a, Float4 b) { return {_mm_min_ps(a.v, b.v)}; }
+inline Float4 max(Float4 a, Float4 b) { return {_mm_max_ps(a.v, b.v)}; }
+inline Float4 sqrt(Float4 a) { return {_mm_sqrt_ps(a.v)}; }
+
+// {a0 a1 a2 a3} {b0 b1 b2 b3} -> {a0 a2 b0 b2} {a1 a3 b1 b3}
+inline void deinterleave(Float4 a, Float4 b, Float4& even, Float4& odd)
+{
+    even.v = _mm_shuffle_ps(a.v, b.v, _MM_SHUFFLE(2, 0, 2, 0));
+    odd.v = _mm_shuffle_ps(a.v, b.v, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+// {a0 a1 a2 a3} {b0 b1 b2 b3} -> {a0 b0 a1 b1} {a2 b2 a3 b3}
+inline void interleave(Float4 a, Float4 b, Float4& low, Float4& high)
+{
+    low.v = _mm_unpacklo_ps(a.v, b.v);
+    high.v = _mm_unpackhi_ps(a.v, b.v);
+}
+
+#elif defined(SDLWRAPPER_SIMD_NEON)
+
+inline Float4 Float4::load(const float* p) { return {vld1q_f32(p)}; }
+inline Float4 Float4::splat(float f) { return {vdupq_n_f32(f)}; }
+inline void Float4::store(float* p) const { vst1q_f32(p, v); }
+
+inline Float4 operator+(Float4 a, Float4 b) { return {vaddq_f32(a.v, b.v)}; }
+inline Float4 operator-(Float4 a, Float4 b) { return {vsubq_f32(a.v, b.v)}; }
+inline Float4 operator*(Float4 a, Float4 b) { return {vmulq_f32(a.v, b.v)}; }
+inline Float4 min(Float4 a, Float4 b) { return {vminq_f32(a.v, b.v)}; }
+inline Float4 max(Float4 a, Float4 b) { return {vmaxq_f32(a.v, b.v)}; }
+
+#if defined(__aarch64__)
+inline Float4 operator/(Float4 a, Float4 b) { return {vdivq_f32(a.v, b.v)}; }
+inline Float4 sqrt(Float4 a) { return {vsqrtq_f32(a.v)}; }
+#else
+// 32-bit NEON only has estimates, refined with two Newton-Raphson steps
+inline Float4 operator/(Float4 a, Float4 b)
+{
+    float32x4_t reciprocal = vrecpeq_f32(b.v);
+    reciprocal = vmulq_f32(vrecpsq_f32(b.v, reciprocal), reciprocal);
+    reciprocal = vmulq_f32(vrecpsq_f32(b.v, reciprocal), reciprocal);
+    return {vmulq_f32(a.v, reciprocal)};
+}
+
+inline Float4 sqrt(Float4 a)
+{
+    // the estimate of 1 / sqrt(0) is infinite, so 0 comes out as 0 * (1 / sqrt(FLT_MIN))
+    float32x4_t x = vmaxq_f32(a.v, vdupq_n_f32(FLT_MIN));
+    float32x4_t estimate = vrsqrteq_f32(x);
+    estimate = vmulq_f32(vrsqrtsq_f32(vmulq_f32(x, estimate), estimate), estimate);
+    estimate = vmulq_f32(vrsqrtsq_f32(vmulq_f32(x, estimate), estimate), estimate);
+    return {vmulq_f32(a.v, estimate)};
+}
+#endif
+
+inline void deinterleave(Float4 a, Float4 b, Float4& even, Float4& odd)
+{
+    float32x4x2_t result = vuzpq_f32(a.v, b.v);
+    even.v = result.val[0];
+    odd.v = result.val[1];
+}
+
+inline void interleave(Float4 a, Float4 b, Float4& low, Float4& high)
+{
+    float32x4x2_t result = vzipq_f32(a.v, b.v);
+    low.v = result.val[0];
+    high.v = result.val[1];
+}
+
+#else
+
+inline Float4 Float4::load(const float* p) { return {{p[0], p[1], p[2], p[3]}}; }
+inline Float4 Float4::splat(float f) { return {{f, f, f, f}}; }
+inline void Float4::store(float* p) const { std::copy(v, v + 4, p); }
+
+inline Float4 operator+(Float4 a, Float4 b) { return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}}; }
+inline Float4 operator-(Float4 a, Float4 b) { return {{a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]}}; }
+inline Float4 operator*(Float4 a, Float4 b) { return {{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}}; }
+inline Float4 operator/(Float4 a, Float4 b) { return {{a.v[0] / b.v[0], a.v[1] / b.v[1], a.v[2] / b.v[2], a.v[3] / b.v[3]}}; }
+inline Float4 min(Float4 a, Float4 b) { return {{std::min(a.v[0], b.v[0]), std::min(a.v[1], b.v[1]), std::min(a.v[2], b.v[2]), std::min(a.v[3], b.v[3])}}; }
+inline Float4 max(Float4 a, Float4 b) { return {{std::max(a.v[0], b.v[0]), std::max(a.v[1], b.v[1]), std::max(a.v[2], b.v[2]), std::max(a.v[3], b.v[3])}}; }
+inline Float4 sqrt(Float4 a) { return {{std::sqrt(a.v[0]), std::sqrt(a.v[1]), std::sqrt(a.v[2]), std::sqrt(a.v[3])}}; }
+
+inline void deinterleave(Float4 a, Float4 b, Float4& even, Float4& odd)
+{
+    even = {{a.v[0], a.v[2], b.v[0], b.v[2]}};
+    odd = {{a.v[1], a.v[3], b.v[1], b.v[3]}};
+}
+
+inline void interleave(Float4 a, Float4 b, Float4& low, Float4& high)
+{
+    low = {{a.v[0], b.v[0], a.v[1], b.v[1]}};
+    high = {{a.v[2], b.v[2], a.v[3], b.v[3]}};
+}
+
+#endif
+
+} // namespace detail
+} // namespace sdlwrapper
+
+#endif // SDLWRAPPER_DETAIL_SIMD_HPP
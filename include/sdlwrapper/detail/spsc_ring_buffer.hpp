@@ -0,0 +1,180 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef SDLWRAPPER_DETAIL_SPSC_RING_BUFFER_HPP
+#define SDLWRAPPER_DETAIL_SPSC_RING_BUFFER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+namespace sdlwrapper
+{
+namespace detail
+{
+
+// keep producer and consumer indices on separate cache lines
+constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * @brief Wait-free single producer, single consumer ring buffer.
+ *
+ * Exactly one thread may call the producer functions (write, push),
+ * and exactly one other thread may call the consumer functions (read, pop).
+ * The capacity is rounded up to a power of two, and never reallocates.
+ */
+template <typename T>
+class SpscRingBuffer
+{
+    static_assert(std::is_trivially_copyable_v<T>, "SpscRingBuffer elements are copied with memcpy");
+
+public:
+    explicit SpscRingBuffer(std::size_t capacity);
+
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+    std::size_t getCapacity() const;
+
+    /**
+     * @brief Get the number of elements which can be read.
+     */
+    std::size_t getReadAvailable() const;
+
+    /**
+     * @brief Get the number of elements which can be written.
+     */
+    std::size_t getWriteAvailable() const;
+
+    /**
+     * @brief Write up to count elements. Producer only.
+     * @return Number of elements written
+     */
+    std::size_t write(const T* data, std::size_t count);
+
+    /**
+     * @brief Read up to count elements. Consumer only.
+     * @return Number of elements read
+     */
+    std::size_t read(T* data, std::size_t count);
+
+    /**
+     * @brief Write a single element. Producer only.
+     * @return false if the buffer is full
+     */
+    bool push(const T& value);
+
+    /**
+     * @brief Read a single element. Consumer only.
+     * @return false if the buffer is empty
+     */
+    bool pop(T& value);
+
+private:
+    std::unique_ptr<T[]> _buffer;
+    std::size_t _mask;
+
+    // indices increase forever, and are masked on access
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> _head {}; // written by producer
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> _tail {}; // written by consumer
+};
+
+inline std::size_t nextPowerOfTwo(std::size_t n)
+{
+    std::size_t result = 1;
+    while(result < n) {
+        result <<= 1;
+    }
+    return result;
+}
+
+template <typename T>
+SpscRingBuffer<T>::SpscRingBuffer(std::size_t capacity)
+    : _buffer(new T[nextPowerOfTwo(capacity)]),
+      _mask(nextPowerOfTwo(capacity) - 1)
+{
+    assert(capacity > 0);
+}
+
+template <typename T>
+std::size_t SpscRingBuffer<T>::getCapacity() const
+{
+    return _mask + 1;
+}
+
+template <typename T>
+std::size_t SpscRingBuffer<T>::getReadAvailable() const
+{
+    return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+}
+
+template <typename T>
+std::size_t SpscRingBuffer<T>::getWriteAvailable() const
+{
+    return getCapacity() - getReadAvailable();
+}
+
+template <typename T>
+std::size_t SpscRingBuffer<T>::write(const T* data, std::size_t count)
+{
+    std::size_t head = _head.load(std::memory_order_relaxed);
+    std::size_t tail = _tail.load(std::memory_order_acquire);
+    count = std::min(count, getCapacity() - (head - tail));
+
+    std::size_t start = head & _mask;
+    std::size_t first = std::min(count, getCapacity() - start);
+    std::memcpy(_buffer.get() + start, data, first * sizeof(T));
+    std::memcpy(_buffer.get(), data + first, (count - first) * sizeof(T));
+
+    _head.store(head + count, std::memory_order_release);
+    return count;
+}
+
+template <typename T>
+std::size_t SpscRingBuffer<T>::read(T* data, std::size_t count)
+{
+    std::size_t tail = _tail.load(std::memory_order_relaxed);
+    std::size_t head = _head.load(std::memory_order_acquire);
+    count = std::min(count, head - tail);
+
+    std::size_t start = tail & _mask;
+    std::size_t first = std::min(count, getCapacity() - start);
+    std::memcpy(data, _buffer.get() + start, first * sizeof(T));
+    std::memcpy(data + first, _buffer.get(), (count - first) * sizeof(T));
+
+    _tail.store(tail + count, std::memory_order_release);
+    return count;
+}
+
+template <typename T>
+bool SpscRingBuffer<T>::push(const T& value)
+{
+    return write(&value, 1) == 1;
+}
+
+template <typename T>
+bool SpscRingBuffer<T>::pop(T& value)
+{
+    return read(&value, 1) == 1;
+}
+
+} // namespace detail
+} // namespace sdlwrapper
+
+#endif // SDLWRAPPER_DETAIL_SPSC_RING_BUFFER_HPP
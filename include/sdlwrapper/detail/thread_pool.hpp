@@ -0,0 +1,196 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef SDLWRAPPER_DETAIL_THREAD_POOL_HPP
+#define SDLWRAPPER_DETAIL_THREAD_POOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace sdlwrapper
+{
+namespace detail
+{
+
+/**
+ * @brief Fixed set of worker threads running tasks in submission order.
+ *
+ * Tasks must not wait on other tasks of the same pool, since every worker may be waiting.
+ */
+class ThreadPool
+{
+public:
+    /**
+     * @param threads  Number of workers, or 0 for one per core
+     */
+    explicit ThreadPool(std::size_t threads = 0);
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Finish every submitted task, then join the workers.
+     */
+    ~ThreadPool();
+
+    std::size_t getThreads() const;
+
+    /**
+     * @brief Run f on a worker.
+     * @return Future holding f's result, or the exception it threw
+     */
+    template <typename F>
+    std::future<std::invoke_result_t<F>> submit(F f);
+
+    /**
+     * @brief Call f(i) for every i in [0, count), on the workers and the calling thread, and wait.
+     *
+     * Indices are claimed in increasing order, but may run in any order.
+     * If f throws, unclaimed indices are skipped, and the first exception is rethrown once the others finish.
+     */
+    template <typename F>
+    void parallelFor(std::size_t count, F f);
+
+private:
+    void run();
+
+    std::vector<std::thread> _threads;
+    std::deque<std::function<void()>> _tasks {};
+    std::mutex _mutex {};
+    std::condition_variable _condition {};
+    bool _quit {};
+};
+
+inline ThreadPool::ThreadPool(std::size_t threads)
+{
+    if(threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    _threads.reserve(threads);
+    for(std::size_t i = 0; i < threads; ++i) {
+        _threads.emplace_back(&ThreadPool::run, this);
+    }
+}
+
+inline ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock {_mutex};
+        _quit = true;
+    }
+    _condition.notify_all();
+    for(std::thread& thread : _threads) {
+        thread.join();
+    }
+}
+
+inline std::size_t ThreadPool::getThreads() const
+{
+    return _threads.size();
+}
+
+template <typename F>
+std::future<std::invoke_result_t<F>> ThreadPool::submit(F f)
+{
+    // std::function must be copyable, so share the move-only task
+    auto task = std::make_shared<std::packaged_task<std::invoke_result_t<F>()>>(std::move(f));
+    std::future<std::invoke_result_t<F>> future = task->get_future();
+    {
+        std::lock_guard<std::mutex> lock {_mutex};
+        _tasks.emplace_back([task] { (*task)(); });
+    }
+    _condition.notify_one();
+    return future;
+}
+
+template <typename F>
+void ThreadPool::parallelFor(std::size_t count, F f)
+{
+    std::atomic<std::size_t> next {};
+    auto work = [&] {
+        try {
+            for(std::size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < count;) {
+                f(i);
+            }
+        }
+        catch(...) {
+            // stop every helper claiming more
+            next.store(count);
+            throw;
+        }
+    };
+
+    // the calling thread is one of the helpers
+    std::size_t helpers = std::min(count, _threads.size() + 1);
+    std::vector<std::future<void>> futures;
+    futures.reserve(helpers);
+    for(std::size_t i = 1; i < helpers; ++i) {
+        futures.push_back(submit(work));
+    }
+
+    std::exception_ptr error;
+    try {
+        work();
+    }
+    catch(...) {
+        error = std::current_exception();
+    }
+    for(std::future<void>& future : futures) {
+        try {
+            future.get();
+        }
+        catch(...) {
+            if(!error) {
+                error = std::current_exception();
+            }
+        }
+    }
+    if(error) {
+        std::rethrow_exception(error);
+    }
+}
+
+inline void ThreadPool::run()
+{
+    while(true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock {_mutex};
+            _condition.wait(lock, [this] { return _quit || !_tasks.empty(); });
+            if(_tasks.empty()) {
+                return;
+            }
+            task = std::move(_tasks.front());
+            _tasks.pop_front();
+        }
+        task();
+    }
+}
+
+} // namespace detail
+} // namespace sdlwrapper
+
+#endif // SDLWRAPPER_DETAIL_THREAD_POOL_HPP
@@ -0,0 +1,179 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef SDLWRAPPER_DETAIL_WAV_HEADER_HPP
+#define SDLWRAPPER_DETAIL_WAV_HEADER_HPP
+
+#include "sdlwrapper/sdl_error.hpp"
+#include "sdlwrapper/detail/rwops.hpp"
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace sdlwrapper
+{
+namespace detail
+{
+
+// format of an uncompressed RIFF WAVE file
+struct WavHeader
+{
+    int freq;
+    SDL_AudioFormat format;
+    std::uint8_t channels;
+    std::uint32_t dataOffset;
+    std::uint32_t dataSize;
+};
+
+[[noreturn]] inline void throwWavError(const char* message)
+{
+    SDL_SetError("WAV: %s", message);
+    throw SdlError{};
+}
+
+/**
+ * @brief Parse RIFF WAVE chunks up to the start of the PCM data.
+ *
+ * Only PCM (8, 16 or 32 bit) and IEEE float (32 bit) data is supported,
+ * since the samples are used without decoding.
+ * Leaves rw positioned at the first sample.
+ *
+ * @throws SdlError
+ */
+inline WavHeader readWavHeader(SDL_RWops* rw)
+{
+    constexpr std::uint16_t FORMAT_PCM = 0x0001;
+    constexpr std::uint16_t FORMAT_IEEE_FLOAT = 0x0003;
+    constexpr std::uint16_t FORMAT_EXTENSIBLE = 0xFFFE;
+
+    char id[4];
+    if(SDL_RWread(rw, id, 4, 1) != 1 || std::memcmp(id, "RIFF", 4) != 0) {
+        throwWavError("missing RIFF chunk");
+    }
+    SDL_ReadLE32(rw);
+    if(SDL_RWread(rw, id, 4, 1) != 1 || std::memcmp(id, "WAVE", 4) != 0) {
+        throwWavError("not a WAVE file");
+    }
+
+    WavHeader header {};
+    std::uint16_t tag = 0;
+    std::uint16_t bits = 0;
+    while(SDL_RWread(rw, id, 4, 1) == 1) {
+        std::uint32_t size = SDL_ReadLE32(rw);
+        Sint64 chunkStart = SDL_RWtell(rw);
+
+        if(std::memcmp(id, "fmt ", 4) == 0) {
+            if(size < 16) {
+                throwWavError("fmt chunk too small");
+            }
+            tag = SDL_ReadLE16(rw);
+            header.channels = static_cast<std::uint8_t>(SDL_ReadLE16(rw));
+            header.freq = static_cast<int>(SDL_ReadLE32(rw));
+            SDL_ReadLE32(rw); // byte rate
+            SDL_ReadLE16(rw); // block align
+            bits = SDL_ReadLE16(rw);
+            if(tag == FORMAT_EXTENSIBLE && size >= 40) {
+                SDL_ReadLE16(rw); // extension size
+                SDL_ReadLE16(rw); // valid bits
+                SDL_ReadLE32(rw); // channel mask
+                tag = SDL_ReadLE16(rw); // first two bytes of the sub format GUID
+            }
+        }
+        else if(std::memcmp(id, "data", 4) == 0) {
+            if(tag == 0) {
+                throwWavError("data chunk before fmt chunk");
+            }
+            header.dataOffset = static_cast<std::uint32_t>(chunkStart);
+            header.dataSize = size;
+
+            // tolerate truncated files
+            Sint64 fileSize = SDL_RWsize(rw);
+            if(fileSize >= 0) {
+                header.dataSize = static_cast<std::uint32_t>(std::min<Sint64>(size, std::max<Sint64>(fileSize - chunkStart, 0)));
+            }
+            break;
+        }
+
+        // chunks are padded to an even size
+        if(SDL_RWseek(rw, chunkStart + size + (size & 1), RW_SEEK_SET) < 0) {
+            throwWavError("truncated chunk");
+        }
+    }
+
+    if(header.dataOffset == 0) {
+        throwWavError("missing data chunk");
+    }
+
+    if(tag == FORMAT_PCM && bits == 8) {
+        header.format = AUDIO_U8;
+    }
+    else if(tag == FORMAT_PCM && bits == 16) {
+        header.format = AUDIO_S16LSB;
+    }
+    else if(tag == FORMAT_PCM && bits == 32) {
+        header.format = AUDIO_S32LSB;
+    }
+    else if(tag == FORMAT_IEEE_FLOAT && bits == 32) {
+        header.format = AUDIO_F32LSB;
+    }
+    else {
+        throwWavError("unsupported sample format");
+    }
+
+    if(header.channels == 0) {
+        throwWavError("no channels");
+    }
+
+    return header;
+}
+
+/**
+ * @brief Write a canonical 44 byte RIFF WAVE header, followed by dataSize bytes of samples.
+ *
+ * format must be AUDIO_U8, AUDIO_S16LSB, AUDIO_S32LSB or AUDIO_F32LSB.
+ *
+ * @throws SdlError
+ */
+inline void writeWavHeader(SDL_RWops* rw, int freq, SDL_AudioFormat format, std::uint8_t channels, std::uint32_t dataSize)
+{
+    constexpr std::uint16_t FORMAT_PCM = 0x0001;
+    constexpr std::uint16_t FORMAT_IEEE_FLOAT = 0x0003;
+
+    std::uint16_t blockAlign = static_cast<std::uint16_t>(channels * SDL_AUDIO_BITSIZE(format) / 8);
+
+    bool ok = SDL_RWwrite(rw, "RIFF", 4, 1) == 1
+        && SDL_WriteLE32(rw, 36 + dataSize) == 1
+        && SDL_RWwrite(rw, "WAVEfmt ", 8, 1) == 1
+        && SDL_WriteLE32(rw, 16) == 1
+        && SDL_WriteLE16(rw, SDL_AUDIO_ISFLOAT(format) ? FORMAT_IEEE_FLOAT : FORMAT_PCM) == 1
+        && SDL_WriteLE16(rw, channels) == 1
+        && SDL_WriteLE32(rw, static_cast<std::uint32_t>(freq)) == 1
+        && SDL_WriteLE32(rw, static_cast<std::uint32_t>(freq) * blockAlign) == 1
+        && SDL_WriteLE16(rw, blockAlign) == 1
+        && SDL_WriteLE16(rw, SDL_AUDIO_BITSIZE(format)) == 1
+        && SDL_RWwrite(rw, "data", 4, 1) == 1
+        && SDL_WriteLE32(rw, dataSize) == 1;
+    if(!ok) {
+        throwWavError("write failed");
+    }
+}
+
+} // namespace detail
+} // namespace sdlwrapper
+
+#endif // SDLWRAPPER_DETAIL_WAV_HEADER_HPP
@@ -0,0 +1,686 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef SDLWRAPPER_EFFECT_GRAPH_HPP
+#define SDLWRAPPER_EFFECT_GRAPH_HPP
+
+#include "sdlwrapper/sdl_error.hpp"
+#include "sdlwrapper/detail/simd.hpp"
+#include "sdlwrapper/detail/spsc_ring_buffer.hpp"
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace sdlwrapper
+{
+
+enum class BiquadType
+{
+    LOW_PASS,
+    HIGH_PASS,
+    BAND_PASS,
+    NOTCH,
+    PEAK,
+    LOW_SHELF,
+    HIGH_SHELF
+};
+
+namespace detail
+{
+
+// normalized so a0 is 1
+struct BiquadCoefficients
+{
+    float b0;
+    float b1;
+    float b2;
+    float a1;
+    float a2;
+};
+
+// Robert Bristow-Johnson's audio EQ cookbook
+inline BiquadCoefficients makeBiquadCoefficients(BiquadType type, double freq, double sampleRate, double q, double gainDb)
+{
+    double w0 = 2.0 * M_PI * std::min(freq, sampleRate * 0.49) / sampleRate;
+    double cosW0 = std::cos(w0);
+    double alpha = std::sin(w0) / (2.0 * q);
+    double a = std::pow(10.0, gainDb / 40.0);
+    double shelf = 2.0 * std::sqrt(a) * alpha;
+
+    double b0, b1, b2, a0, a1, a2;
+    switch(type) {
+    case BiquadType::LOW_PASS:
+        b0 = (1.0 - cosW0) / 2.0; b1 = 1.0 - cosW0; b2 = b0;
+        a0 = 1.0 + alpha; a1 = -2.0 * cosW0; a2 = 1.0 - alpha;
+        break;
+    case BiquadType::HIGH_PASS:
+        b0 = (1.0 + cosW0) / 2.0; b1 = -(1.0 + cosW0); b2 = b0;
+        a0 = 1.0 + alpha; a1 = -2.0 * cosW0; a2 = 1.0 - alpha;
+        break;
+    case BiquadType::BAND_PASS:
+        b0 = alpha; b1 = 0.0; b2 = -alpha;
+        a0 = 1.0 + alpha; a1 = -2.0 * cosW0; a2 = 1.0 - alpha;
+        break;
+    case BiquadType::NOTCH:
+        b0 = 1.0; b1 = -2.0 * cosW0; b2 = 1.0;
+        a0 = 1.0 + alpha; a1 = -2.0 * cosW0; a2 = 1.0 - alpha;
+        break;
+    case BiquadType::PEAK:
+        b0 = 1.0 + alpha * a; b1 = -2.0 * cosW0; b2 = 1.0 - alpha * a;
+        a0 = 1.0 + alpha / a; a1 = -2.0 * cosW0; a2 = 1.0 - alpha / a;
+        break;
+    case BiquadType::LOW_SHELF:
+        b0 = a * ((a + 1.0) - (a - 1.0) * cosW0 + shelf);
+        b1 = 2.0 * a * ((a - 1.0) - (a + 1.0) * cosW0);
+        b2 = a * ((a + 1.0) - (a - 1.0) * cosW0 - shelf);
+        a0 = (a + 1.0) + (a - 1.0) * cosW0 + shelf;
+        a1 = -2.0 * ((a - 1.0) + (a + 1.0) * cosW0);
+        a2 = (a + 1.0) + (a - 1.0) * cosW0 - shelf;
+        break;
+    case BiquadType::HIGH_SHELF:
+    default:
+        b0 = a * ((a + 1.0) + (a - 1.0) * cosW0 + shelf);
+        b1 = -2.0 * a * ((a - 1.0) + (a + 1.0) * cosW0);
+        b2 = a * ((a + 1.0) + (a - 1.0) * cosW0 - shelf);
+        a0 = (a + 1.0) - (a - 1.0) * cosW0 + shelf;
+        a1 = 2.0 * ((a - 1.0) - (a + 1.0) * cosW0);
+        a2 = (a + 1.0) - (a - 1.0) * cosW0 - shelf;
+        break;
+    }
+
+    return {static_cast<float>(b0 / a0), static_cast<float>(b1 / a0), static_cast<float>(b2 / a0),
+            static_cast<float>(a1 / a0), static_cast<float>(a2 / a0)};
+}
+
+// transposed direct form II, the recursion is serial so this stays scalar
+inline void processBiquad(float* samples, std::size_t frames, const BiquadCoefficients& c, float* state)
+{
+    float z1 = state[0];
+    float z2 = state[1];
+    for(std::size_t i = 0; i < frames; ++i) {
+        float x = samples[i];
+        float y = c.b0 * x + z1;
+        z1 = c.b1 * x - c.a1 * y + z2;
+        z2 = c.b2 * x - c.a2 * y;
+        samples[i] = y;
+    }
+    state[0] = z1;
+    state[1] = z2;
+}
+
+// samples[i] *= start + step * i
+inline void applyGainRamp(float* samples, std::size_t frames, float start, float step)
+{
+    std::size_t i = 0;
+    Float4 gain4 = Float4::load(std::array<float, 4>{start, start + step, start + step * 2, start + step * 3}.data());
+    Float4 step4 = Float4::splat(step * Float4::SIZE);
+    for(; i + Float4::SIZE <= frames; i += Float4::SIZE) {
+        (Float4::load(samples + i) * gain4).store(samples + i);
+        gain4 = gain4 + step4;
+    }
+    for(; i < frames; ++i) {
+        samples[i] *= start + step * static_cast<float>(i);
+    }
+}
+
+// dst[i] += src[i] * (start + step * i)
+inline void accumulateGainRamp(float* dst, const float* src, std::size_t frames, float start, float step)
+{
+    std::size_t i = 0;
+    Float4 gain4 = Float4::load(std::array<float, 4>{start, start + step, start + step * 2, start + step * 3}.data());
+    Float4 step4 = Float4::splat(step * Float4::SIZE);
+    for(; i + Float4::SIZE <= frames; i += Float4::SIZE) {
+        (Float4::load(dst + i) + Float4::load(src + i) * gain4).store(dst + i);
+        gain4 = gain4 + step4;
+    }
+    for(; i < frames; ++i) {
+        dst[i] += src[i] * (start + step * static_cast<float>(i));
+    }
+}
+
+// peaks[i] = max(peaks[i], |samples[i]|)
+inline void accumulatePeak(float* peaks, const float* samples, std::size_t frames)
+{
+    std::size_t i = 0;
+    Float4 zero = Float4::splat(0.0f);
+    for(; i + Float4::SIZE <= frames; i += Float4::SIZE) {
+        Float4 s = Float4::load(samples + i);
+        max(Float4::load(peaks + i), max(s, zero - s)).store(peaks + i);
+    }
+    for(; i < frames; ++i) {
+        peaks[i] = std::max(peaks[i], std::abs(samples[i]));
+    }
+}
+
+// samples[i] *= gains[i]
+inline void applyGains(float* samples, const float* gains, std::size_t frames)
+{
+    std::size_t i = 0;
+    for(; i + Float4::SIZE <= frames; i += Float4::SIZE) {
+        (Float4::load(samples + i) * Float4::load(gains + i)).store(samples + i);
+    }
+    for(; i < frames; ++i) {
+        samples[i] *= gains[i];
+    }
+}
+
+// planar[channel * stride + i] = interleaved[i * channels + channel]
+inline void deinterleave(float* planar, std::size_t stride, const float* interleaved, std::size_t frames, std::uint8_t channels)
+{
+    if(channels == 2) {
+        float* left = planar;
+        float* right = planar + stride;
+        std::size_t i = 0;
+        for(; i + Float4::SIZE <= frames; i += Float4::SIZE) {
+            Float4 l, r;
+            deinterleave(Float4::load(interleaved + i * 2), Float4::load(interleaved + i * 2 + Float4::SIZE), l, r);
+            l.store(left + i);
+            r.store(right + i);
+        }
+        for(; i < frames; ++i) {
+            left[i] = interleaved[i * 2];
+            right[i] = interleaved[i * 2 + 1];
+        }
+        return;
+    }
+    for(std::uint8_t channel = 0; channel < channels; ++channel) {
+        for(std::size_t i = 0; i < frames; ++i) {
+            planar[channel * stride + i] = interleaved[i * channels + channel];
+        }
+    }
+}
+
+// interleaved[i * channels + channel] = planar[channel * stride + i]
+inline void interleave(float* interleaved, const float* planar, std::size_t stride, std::size_t frames, std::uint8_t channels)
+{
+    if(channels == 2) {
+        const float* left = planar;
+        const float* right = planar + stride;
+        std::size_t i = 0;
+        for(; i + Float4::SIZE <= frames; i += Float4::SIZE) {
+            Float4 first, second;
+            interleave(Float4::load(left + i), Float4::load(right + i), first, second);
+            first.store(interleaved + i * 2);
+            second.store(interleaved + i * 2 + Float4::SIZE);
+        }
+        for(; i < frames; ++i) {
+            interleaved[i * 2] = left[i];
+            interleaved[i * 2 + 1] = right[i];
+        }
+        return;
+    }
+    for(std::uint8_t channel = 0; channel < channels; ++channel) {
+        for(std::size_t i = 0; i < frames; ++i) {
+            interleaved[i * channels + channel] = planar[channel * stride + i];
+        }
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Chain of filters, gains and limiters applied to an AUDIO_F32SYS device's output.
+ *
+ * Audio enters the INPUT bus, which returns into MASTER, and MASTER is the output.
+ * Each bus runs its effects in the order they were added, then returns into its output bus.
+ * Sends mix a bus, as processed so far, into another bus.
+ *
+ * The game thread edits the graph, then commit() sorts the buses and compiles every effect
+ * into a flat list of operations on planar blocks, and hands it to the audio thread without locking.
+ * Gains, send gains and limiter thresholds change live, everything else at the next commit.
+ * Filter and gain state is kept across commits.
+ */
+class EffectGraph
+{
+public:
+    using BusId = std::uint32_t;
+    using EffectId = std::uint32_t;
+
+    static constexpr BusId MASTER = 0;
+    static constexpr BusId INPUT = 1;
+
+    // frames processed at a time
+    static constexpr std::size_t BLOCK_FRAMES = 256;
+
+    /**
+     * @param source  Callback writing interleaved float samples, run before the graph, or nullptr for silence
+     * @param userdata  Passed to source
+     */
+    EffectGraph(int freq, std::uint8_t channels, SDL_AudioCallback source = nullptr, void* userdata = nullptr);
+
+    EffectGraph(const EffectGraph&) = delete;
+    EffectGraph& operator=(const EffectGraph&) = delete;
+
+    /**
+     * @brief Destroy the graph. The device using it must be closed or paused first.
+     */
+    ~EffectGraph();
+
+    /**
+     * @brief Add a bus, for example the return of a send. Game thread only.
+     * @param output  Bus to mix into after this bus's effects
+     */
+    BusId addBus(BusId output = MASTER);
+
+    /**
+     * @brief Add a filter to the end of a bus. Game thread only.
+     * @param gainDb  Gain for PEAK, LOW_SHELF and HIGH_SHELF, ignored by other types
+     */
+    EffectId addBiquad(BusId bus, BiquadType type, float freq, float q = 0.7071f, float gainDb = 0.0f);
+
+    /**
+     * @brief Add a gain to the end of a bus. Game thread only.
+     * @param smoothingMs  Time constant of the ramp to a new gain
+     */
+    EffectId addGain(BusId bus, float gain = 1.0f, float smoothingMs = 10.0f);
+
+    /**
+     * @brief Add a peak limiter to the end of a bus, which never lets samples exceed threshold. Game thread only.
+     * @param releaseMs  Time constant of the gain recovering after a peak
+     */
+    EffectId addLimiter(BusId bus, float threshold = 1.0f, float releaseMs = 50.0f);
+
+    /**
+     * @brief Mix a bus, as processed so far, into another bus. Game thread only.
+     */
+    EffectId addSend(BusId bus, BusId target, float gain = 1.0f, float smoothingMs = 10.0f);
+
+    /**
+     * @brief Change a filter's parameters, from the next commit. Game thread only.
+     */
+    void setBiquad(EffectId effect, BiquadType type, float freq, float q = 0.7071f, float gainDb = 0.0f);
+
+    /**
+     * @brief Change the gain of a gain or send effect, immediately. Any thread.
+     */
+    void setGain(EffectId effect, float gain);
+
+    /**
+     * @brief Change the threshold of a limiter, immediately. Any thread.
+     */
+    void setLimiterThreshold(EffectId effect, float threshold);
+
+    /**
+     * @brief Compile the graph and hand it to the audio thread. Game thread only.
+     * @throws SdlError if sends form a cycle
+     */
+    void commit();
+
+    /**
+     * @brief Run the last committed graph in place. Audio thread only.
+     */
+    void process(float* interleaved, std::size_t frames);
+
+    /**
+     * @brief SDL_AudioCallback for an AUDIO_F32SYS AudioDevice, pass the EffectGraph as userdata.
+     */
+    static void callback(void* userdata, std::uint8_t* stream, int len);
+
+private:
+    enum class EffectType : std::uint8_t
+    {
+        BIQUAD,
+        GAIN,
+        LIMITER,
+        SEND
+    };
+
+    struct Effect
+    {
+        EffectType type;
+        BusId bus;
+        BusId target;
+        detail::BiquadCoefficients coefficients;
+        // gain or limiter threshold
+        std::atomic<float> parameter;
+        // smoothing time constant or limiter release, in frames
+        float timeFrames;
+
+        // audio thread state: smoothed gain or limiter envelope, and 2 biquad states per channel
+        float current;
+        std::unique_ptr<float[]> state;
+    };
+
+    struct Operation
+    {
+        EffectType type;
+        std::uint32_t bus;
+        std::uint32_t target;
+        Effect* effect;
+        detail::BiquadCoefficients coefficients;
+    };
+
+    struct Program
+    {
+        std::vector<Operation> operations;
+        // buses in order, then bus returns, as (bus, output) pairs
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> returns;
+        // channels * BLOCK_FRAMES floats per bus
+        std::vector<float> buffers;
+        std::vector<float> scratch;
+    };
+
+    EffectId addEffect(BusId bus, EffectType type);
+    void processBlock(Program& program, float* interleaved, std::size_t frames);
+    void deleteRetired();
+
+    int _freq;
+    std::uint8_t _channels;
+    SDL_AudioCallback _source;
+    void* _userdata;
+
+    // game thread state, effects never move so the audio thread can point at them
+    std::vector<BusId> _busOutputs;
+    std::vector<std::vector<EffectId>> _busEffects;
+    std::deque<Effect> _effects;
+
+    // game thread to audio thread, the audio thread takes the pending program
+    std::atomic<Program*> _pending {};
+    // audio thread to game thread, programs which can be deleted
+    detail::SpscRingBuffer<Program*> _retired;
+
+    // audio thread state
+    Program* _program {};
+};
+
+inline EffectGraph::EffectGraph(int freq, std::uint8_t channels, SDL_AudioCallback source, void* userdata)
+    : _freq(freq),
+      _channels(channels),
+      _source(source),
+      _userdata(userdata),
+      _busOutputs{MASTER, MASTER},
+      _busEffects(2),
+      // one pickup per commit, and every commit deletes retired programs first
+      _retired(4)
+{
+    assert(freq > 0 && channels > 0);
+    commit();
+}
+
+inline EffectGraph::~EffectGraph()
+{
+    deleteRetired();
+    delete _pending.load();
+    delete _program;
+}
+
+inline EffectGraph::BusId EffectGraph::addBus(BusId output)
+{
+    assert(output < _busOutputs.size());
+    _busOutputs.push_back(output);
+    _busEffects.emplace_back();
+    return static_cast<BusId>(_busOutputs.size() - 1);
+}
+
+inline EffectGraph::EffectId EffectGraph::addBiquad(BusId bus, BiquadType type, float freq, float q, float gainDb)
+{
+    EffectId id = addEffect(bus, EffectType::BIQUAD);
+    setBiquad(id, type, freq, q, gainDb);
+    return id;
+}
+
+inline EffectGraph::EffectId EffectGraph::addGain(BusId bus, float gain, float smoothingMs)
+{
+    EffectId id = addEffect(bus, EffectType::GAIN);
+    Effect& effect = _effects[id];
+    effect.parameter.store(gain);
+    effect.current = gain;
+    effect.timeFrames = smoothingMs * 0.001f * _freq;
+    return id;
+}
+
+inline EffectGraph::EffectId EffectGraph::addLimiter(BusId bus, float threshold, float releaseMs)
+{
+    EffectId id = addEffect(bus, EffectType::LIMITER);
+    Effect& effect = _effects[id];
+    effect.parameter.store(threshold);
+    effect.timeFrames = releaseMs * 0.001f * _freq;
+    return id;
+}
+
+inline EffectGraph::EffectId EffectGraph::addSend(BusId bus, BusId target, float gain, float smoothingMs)
+{
+    assert(target < _busOutputs.size() && target != bus);
+    EffectId id = addEffect(bus, EffectType::SEND);
+    Effect& effect = _effects[id];
+    effect.target = target;
+    effect.parameter.store(gain);
+    effect.current = gain;
+    effect.timeFrames = smoothingMs * 0.001f * _freq;
+    return id;
+}
+
+inline void EffectGraph::setBiquad(EffectId effect, BiquadType type, float freq, float q, float gainDb)
+{
+    assert(effect < _effects.size() && _effects[effect].type == EffectType::BIQUAD);
+    _effects[effect].coefficients = detail::makeBiquadCoefficients(type, freq, _freq, q, gainDb);
+}
+
+inline void EffectGraph::setGain(EffectId effect, float gain)
+{
+    assert(effect < _effects.size() && (_effects[effect].type == EffectType::GAIN || _effects[effect].type == EffectType::SEND));
+    _effects[effect].parameter.store(gain, std::memory_order_relaxed);
+}
+
+inline void EffectGraph::setLimiterThreshold(EffectId effect, float threshold)
+{
+    assert(effect < _effects.size() && _effects[effect].type == EffectType::LIMITER);
+    _effects[effect].parameter.store(threshold, std::memory_order_relaxed);
+}
+
+inline void EffectGraph::commit()
+{
+    deleteRetired();
+
+    // order buses so each runs after every bus which returns or sends into it
+    std::size_t numBuses = _busOutputs.size();
+    std::vector<std::vector<BusId>> edges(numBuses);
+    std::vector<std::uint32_t> inputs(numBuses);
+    for(BusId bus = 0; bus < numBuses; ++bus) {
+        if(bus != MASTER) {
+            edges[bus].push_back(_busOutputs[bus]);
+        }
+        for(EffectId id : _busEffects[bus]) {
+            if(_effects[id].type == EffectType::SEND) {
+                edges[bus].push_back(_effects[id].target);
+            }
+        }
+        for(BusId next : edges[bus]) {
+            ++inputs[next];
+        }
+    }
+
+    std::vector<BusId> order;
+    for(BusId bus = 0; bus < numBuses; ++bus) {
+        if(inputs[bus] == 0) {
+            order.push_back(bus);
+        }
+    }
+    for(std::size_t i = 0; i < order.size(); ++i) {
+        for(BusId next : edges[order[i]]) {
+            if(--inputs[next] == 0) {
+                order.push_back(next);
+            }
+        }
+    }
+    if(order.size() != numBuses) {
+        SDL_SetError("EffectGraph sends form a cycle");
+        throw SdlError{};
+    }
+
+    std::unique_ptr<Program> program = std::make_unique<Program>();
+    for(BusId bus : order) {
+        for(EffectId id : _busEffects[bus]) {
+            Effect& effect = _effects[id];
+            program->operations.push_back(Operation{effect.type, bus, effect.target, &effect, effect.coefficients});
+        }
+        if(bus != MASTER) {
+            // a return is a send with a fixed gain of 1
+            program->operations.push_back(Operation{EffectType::SEND, bus, _busOutputs[bus], nullptr, {}});
+        }
+    }
+    program->buffers.resize(numBuses * _channels * BLOCK_FRAMES);
+    program->scratch.resize(BLOCK_FRAMES);
+
+    Program* unused = _pending.exchange(program.release(), std::memory_order_acq_rel);
+    // the audio thread never took it
+    delete unused;
+}
+
+inline void EffectGraph::process(float* interleaved, std::size_t frames)
+{
+    Program* pending = _pending.exchange(nullptr, std::memory_order_acq_rel);
+    if(pending != nullptr) {
+        if(_program != nullptr) {
+            _retired.push(_program);
+        }
+        _program = pending;
+    }
+
+    while(frames > 0) {
+        std::size_t blockFrames = std::min(frames, BLOCK_FRAMES);
+        processBlock(*_program, interleaved, blockFrames);
+        interleaved += blockFrames * _channels;
+        frames -= blockFrames;
+    }
+}
+
+inline void EffectGraph::callback(void* userdata, std::uint8_t* stream, int len)
+{
+    EffectGraph* graph = reinterpret_cast<EffectGraph*>(userdata);
+    if(graph->_source != nullptr) {
+        graph->_source(graph->_userdata, stream, len);
+    }
+    else {
+        std::memset(stream, 0, len);
+    }
+    graph->process(reinterpret_cast<float*>(stream), len / (sizeof(float) * graph->_channels));
+}
+
+inline EffectGraph::EffectId EffectGraph::addEffect(BusId bus, EffectType type)
+{
+    assert(bus < _busOutputs.size());
+    _effects.emplace_back();
+    Effect& effect = _effects.back();
+    effect.type = type;
+    effect.bus = bus;
+    effect.target = bus;
+    effect.coefficients = {1.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    effect.parameter.store(1.0f);
+    effect.timeFrames = 0.0f;
+    effect.current = type == EffectType::LIMITER ? 0.0f : 1.0f;
+    if(type == EffectType::BIQUAD) {
+        effect.state.reset(new float[_channels * 2]());
+    }
+
+    EffectId id = static_cast<EffectId>(_effects.size() - 1);
+    _busEffects[bus].push_back(id);
+    return id;
+}
+
+inline void EffectGraph::processBlock(Program& program, float* interleaved, std::size_t frames)
+{
+    const std::size_t busSize = _channels * BLOCK_FRAMES;
+    float* buffers = program.buffers.data();
+    std::fill(program.buffers.begin(), program.buffers.end(), 0.0f);
+    detail::deinterleave(buffers + INPUT * busSize, BLOCK_FRAMES, interleaved, frames, _channels);
+
+    for(const Operation& operation : program.operations) {
+        float* bus = buffers + operation.bus * busSize;
+        Effect* effect = operation.effect;
+
+        switch(operation.type) {
+        case EffectType::BIQUAD:
+            for(std::uint8_t channel = 0; channel < _channels; ++channel) {
+                detail::processBiquad(bus + channel * BLOCK_FRAMES, frames, operation.coefficients, effect->state.get() + channel * 2);
+            }
+            break;
+
+        case EffectType::GAIN:
+        case EffectType::SEND: {
+            // ramp toward the target by one block's worth of smoothing
+            float start = 1.0f;
+            float step = 0.0f;
+            if(effect != nullptr) {
+                float target = effect->parameter.load(std::memory_order_relaxed);
+                start = effect->current;
+                float end = effect->timeFrames > 0.0f ? start + (target - start) * (1.0f - std::exp(-static_cast<float>(frames) / effect->timeFrames)) : target;
+                if(std::abs(end - target) < 1e-6f) {
+                    end = target;
+                }
+                step = (end - start) / static_cast<float>(frames);
+                effect->current = end;
+            }
+            for(std::uint8_t channel = 0; channel < _channels; ++channel) {
+                float* samples = bus + channel * BLOCK_FRAMES;
+                if(operation.type == EffectType::GAIN) {
+                    detail::applyGainRamp(samples, frames, start, step);
+                }
+                else {
+                    detail::accumulateGainRamp(buffers + operation.target * busSize + channel * BLOCK_FRAMES, samples, frames, start, step);
+                }
+            }
+            break;
+        }
+
+        case EffectType::LIMITER: {
+            float* gains = program.scratch.data();
+            std::fill(gains, gains + frames, 0.0f);
+            for(std::uint8_t channel = 0; channel < _channels; ++channel) {
+                detail::accumulatePeak(gains, bus + channel * BLOCK_FRAMES, frames);
+            }
+
+            // instant attack, exponential release
+            float threshold = effect->parameter.load(std::memory_order_relaxed);
+            float release = effect->timeFrames > 0.0f ? std::exp(-1.0f / effect->timeFrames) : 0.0f;
+            float envelope = effect->current;
+            for(std::size_t i = 0; i < frames; ++i) {
+                envelope = std::max(gains[i], envelope * release);
+                gains[i] = envelope > threshold ? threshold / envelope : 1.0f;
+            }
+            effect->current = envelope;
+
+            for(std::uint8_t channel = 0; channel < _channels; ++channel) {
+                detail::applyGains(bus + channel * BLOCK_FRAMES, gains, frames);
+            }
+            break;
+        }
+        }
+    }
+
+    detail::interleave(interleaved, buffers + MASTER * busSize, BLOCK_FRAMES, frames, _channels);
+}
+
+inline void EffectGraph::deleteRetired()
+{
+    Program* program;
+    while(_retired.pop(program)) {
+        delete program;
+    }
+}
+
+} // namespace sdlwrapper
+
+#endif // SDLWRAPPER_EFFECT_GRAPH_HPP
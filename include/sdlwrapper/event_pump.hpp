@@ -0,0 +1,280 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef SDLWRAPPER_EVENT_PUMP_HPP
+#define SDLWRAPPER_EVENT_PUMP_HPP
+
+#include "sdlwrapper/sdl_error.hpp"
+#include "sdlwrapper/sdl.hpp"
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace sdlwrapper
+{
+
+struct EventPumpStats
+{
+    // events drained by the last pump, in total and per category
+    std::uint32_t events;
+    std::uint32_t controllerEvents;
+    std::uint32_t windowEvents;
+    std::uint32_t keyboardEvents;
+    std::uint32_t userEvents;
+    std::uint32_t otherEvents;
+
+    // SDL_PeepEvents calls made by the last pump
+    std::uint32_t batches;
+
+    // time spent pumping, draining and sorting
+    std::uint32_t drainUs;
+
+    // most events drained by one pump so far
+    std::uint32_t peakEvents;
+};
+
+/**
+ * @brief Drains the event queue once per frame, sorted into typed arrays by category.
+ *
+ * Events are fetched with SDL_PeepEvents a batch at a time, into a buffer allocated up front,
+ * then copied into one array per event struct. The arrays keep their capacity between pumps,
+ * so once they have grown to the largest frame seen, pumping never allocates.
+ * Each array holds one frame's events in queue order, until the next pump.
+ *
+ * Like SDL_PumpEvents, only call from the thread which initialized the video subsystem.
+ */
+class EventPump
+{
+public:
+    /**
+     * @param batchSize  Events fetched per SDL_PeepEvents call, and the initial capacity of each array
+     */
+    explicit EventPump(const EventsSubsystem&, std::size_t batchSize = 256);
+
+    EventPump(const EventPump&) = delete;
+    EventPump& operator=(const EventPump&) = delete;
+
+    /**
+     * @brief Replace the previous frame's events with every event queued now.
+     * @throws SdlError
+     */
+    const EventPumpStats& pump();
+
+    /**
+     * @brief Get SDL_CONTROLLERAXISMOTION events.
+     */
+    const std::vector<SDL_ControllerAxisEvent>& getControllerAxisEvents() const;
+
+    /**
+     * @brief Get SDL_CONTROLLERBUTTONDOWN and SDL_CONTROLLERBUTTONUP events.
+     */
+    const std::vector<SDL_ControllerButtonEvent>& getControllerButtonEvents() const;
+
+    /**
+     * @brief Get SDL_CONTROLLERDEVICEADDED, SDL_CONTROLLERDEVICEREMOVED and SDL_CONTROLLERDEVICEREMAPPED events.
+     */
+    const std::vector<SDL_ControllerDeviceEvent>& getControllerDeviceEvents() const;
+
+    /**
+     * @brief Get SDL_WINDOWEVENT events.
+     */
+    const std::vector<SDL_WindowEvent>& getWindowEvents() const;
+
+    /**
+     * @brief Get SDL_KEYDOWN and SDL_KEYUP events.
+     */
+    const std::vector<SDL_KeyboardEvent>& getKeyboardEvents() const;
+
+    /**
+     * @brief Get events registered with SDL_RegisterEvents, from SDL_USEREVENT up.
+     */
+    const std::vector<SDL_UserEvent>& getUserEvents() const;
+
+    /**
+     * @brief Get every other event, including SDL_QUIT.
+     */
+    const std::vector<SDL_Event>& getOtherEvents() const;
+
+    /**
+     * @brief Check for SDL_QUIT in the last pump.
+     */
+    bool isQuitRequested() const;
+
+    const EventPumpStats& getStats() const;
+
+private:
+    void sort(const SDL_Event& event);
+
+    std::vector<SDL_Event> _batch;
+
+    std::vector<SDL_ControllerAxisEvent> _controllerAxisEvents;
+    std::vector<SDL_ControllerButtonEvent> _controllerButtonEvents;
+    std::vector<SDL_ControllerDeviceEvent> _controllerDeviceEvents;
+    std::vector<SDL_WindowEvent> _windowEvents;
+    std::vector<SDL_KeyboardEvent> _keyboardEvents;
+    std::vector<SDL_UserEvent> _userEvents;
+    std::vector<SDL_Event> _otherEvents;
+    bool _quit {};
+
+    EventPumpStats _stats {};
+};
+
+inline EventPump::EventPump(const EventsSubsystem&, std::size_t batchSize)
+    : _batch(batchSize)
+{
+    assert(batchSize > 0);
+
+    _controllerAxisEvents.reserve(batchSize);
+    _controllerButtonEvents.reserve(batchSize);
+    _controllerDeviceEvents.reserve(batchSize);
+    _windowEvents.reserve(batchSize);
+    _keyboardEvents.reserve(batchSize);
+    _userEvents.reserve(batchSize);
+    _otherEvents.reserve(batchSize);
+}
+
+inline const EventPumpStats& EventPump::pump()
+{
+    std::uint64_t start = SDL_GetPerformanceCounter();
+
+    _controllerAxisEvents.clear();
+    _controllerButtonEvents.clear();
+    _controllerDeviceEvents.clear();
+    _windowEvents.clear();
+    _keyboardEvents.clear();
+    _userEvents.clear();
+    _otherEvents.clear();
+    _quit = false;
+
+    SDL_PumpEvents();
+
+    std::uint32_t events = 0;
+    std::uint32_t batches = 0;
+    while(true) {
+        int count = SDL_PeepEvents(_batch.data(), static_cast<int>(_batch.size()), SDL_GETEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT);
+        if(count < 0) {
+            throw SdlError{};
+        }
+        ++batches;
+
+        for(int i = 0; i < count; ++i) {
+            sort(_batch[i]);
+        }
+        events += static_cast<std::uint32_t>(count);
+
+        // a short batch emptied the queue
+        if(static_cast<std::size_t>(count) < _batch.size()) {
+            break;
+        }
+    }
+
+    _stats.events = events;
+    _stats.controllerEvents = static_cast<std::uint32_t>(_controllerAxisEvents.size() + _controllerButtonEvents.size() + _controllerDeviceEvents.size());
+    _stats.windowEvents = static_cast<std::uint32_t>(_windowEvents.size());
+    _stats.keyboardEvents = static_cast<std::uint32_t>(_keyboardEvents.size());
+    _stats.userEvents = static_cast<std::uint32_t>(_userEvents.size());
+    _stats.otherEvents = static_cast<std::uint32_t>(_otherEvents.size());
+    _stats.batches = batches;
+    _stats.drainUs = static_cast<std::uint32_t>((SDL_GetPerformanceCounter() - start) * 1000000 / SDL_GetPerformanceFrequency());
+    _stats.peakEvents = std::max(_stats.peakEvents, events);
+    return _stats;
+}
+
+inline const std::vector<SDL_ControllerAxisEvent>& EventPump::getControllerAxisEvents() const
+{
+    return _controllerAxisEvents;
+}
+
+inline const std::vector<SDL_ControllerButtonEvent>& EventPump::getControllerButtonEvents() const
+{
+    return _controllerButtonEvents;
+}
+
+inline const std::vector<SDL_ControllerDeviceEvent>& EventPump::getControllerDeviceEvents() const
+{
+    return _controllerDeviceEvents;
+}
+
+inline const std::vector<SDL_WindowEvent>& EventPump::getWindowEvents() const
+{
+    return _windowEvents;
+}
+
+inline const std::vector<SDL_KeyboardEvent>& EventPump::getKeyboardEvents() const
+{
+    return _keyboardEvents;
+}
+
+inline const std::vector<SDL_UserEvent>& EventPump::getUserEvents() const
+{
+    return _userEvents;
+}
+
+inline const std::vector<SDL_Event>& EventPump::getOtherEvents() const
+{
+    return _otherEvents;
+}
+
+inline bool EventPump::isQuitRequested() const
+{
+    return _quit;
+}
+
+inline const EventPumpStats& EventPump::getStats() const
+{
+    return _stats;
+}
+
+inline void EventPump::sort(const SDL_Event& event)
+{
+    switch(event.type) {
+    case SDL_CONTROLLERAXISMOTION:
+        _controllerAxisEvents.push_back(event.caxis);
+        break;
+    case SDL_CONTROLLERBUTTONDOWN:
+    case SDL_CONTROLLERBUTTONUP:
+        _controllerButtonEvents.push_back(event.cbutton);
+        break;
+    case SDL_CONTROLLERDEVICEADDED:
+    case SDL_CONTROLLERDEVICEREMOVED:
+    case SDL_CONTROLLERDEVICEREMAPPED:
+        _controllerDeviceEvents.push_back(event.cdevice);
+        break;
+    case SDL_WINDOWEVENT:
+        _windowEvents.push_back(event.window);
+        break;
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+        _keyboardEvents.push_back(event.key);
+        break;
+    default:
+        if(event.type >= SDL_USEREVENT && event.type < SDL_LASTEVENT) {
+            _userEvents.push_back(event.user);
+        }
+        else {
+            _quit = _quit || event.type == SDL_QUIT;
+            _otherEvents.push_back(event);
+        }
+        break;
+    }
+}
+
+} // namespace sdlwrapper
+
+#endif // SDLWRAPPER_EVENT_PUMP_HPP
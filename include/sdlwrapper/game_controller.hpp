@@ -23,6 +23,8 @@
 
 #include <algorithm>
 #include <array>
+#include <cassert>
+#include <cstdint>
 #include <limits>
 
 namespace sdlwrapper
@@ -39,8 +41,18 @@ struct GameControllerDeleter
     }
 };
 
+inline float normalizeAxis(std::int16_t value)
+{
+    float val = static_cast<float>(value) / static_cast<float>(std::numeric_limits<std::int16_t>::max());
+    // since original val is signed, it goes 1 further in negative direction than positive
+    // so we clamp at -1.0f
+    return std::max(-1.0f, val);
+}
+
 } // namespace detail
 
+struct GameControllerState;
+
 class GameController
 {
 public:
@@ -119,11 +131,55 @@ public:
 
     SDL_JoystickID getInstanceID() const;
 
+    /**
+     * @brief Read every button and axis at once, so the rest of the frame reads plain memory.
+     *
+     * @param previous  Last frame's snapshot, to find the buttons pressed and released since
+     */
+    GameControllerState snapshot(const GameControllerState& previous) const;
+
+    /**
+     * @brief Read every button and axis at once, counting every held button as pressed.
+     */
+    GameControllerState snapshot() const;
+
 private:
 
     cwrapper::Resource<SDL_GameController*, detail::GameControllerDeleter> _resource {};
 };
 
+/**
+ * @brief Every button and axis of a GameController at one moment.
+ */
+struct GameControllerState
+{
+    // bit n is set while the button with value n is held
+    std::uint32_t buttons {};
+    // buttons held now but not in the previous snapshot
+    std::uint32_t pressed {};
+    // buttons held in the previous snapshot but not now
+    std::uint32_t released {};
+    // indexed by axis value
+    std::array<std::int16_t, SDL_CONTROLLER_AXIS_MAX> axes {};
+
+    static std::uint32_t getMask(GameController::Button button);
+
+    /**
+     * @brief Set pressed and released from the buttons held in a previous snapshot.
+     */
+    void updateEdges(const GameControllerState& previous);
+
+    bool isDown(GameController::Button button) const;
+
+    bool wasPressed(GameController::Button button) const;
+
+    bool wasReleased(GameController::Button button) const;
+
+    std::int16_t get(GameController::Axis axis) const;
+
+    float getFloat(GameController::Axis axis) const;
+};
+
 inline GameController::GameController(const GameControllerSubsystem&, int index)
     : _resource(SDL_GameControllerOpen(index))
 {
@@ -139,10 +195,7 @@ inline int16_t GameController::get(GameController::Axis axis) const
 
 inline float GameController::getFloat(GameController::Axis axis) const
 {
-    float val = static_cast<float>(get(axis)) / static_cast<float>(std::numeric_limits<int16_t>::max());
-    // since original val is signed, it goes 1 further in negative direction than positive
-    // so we clamp at -1.0f
-    return std::max(-1.0f, val);
+    return detail::normalizeAxis(get(axis));
 }
 
 inline bool GameController::get(GameController::Button button) const
@@ -168,6 +221,68 @@ inline SDL_JoystickID GameController::getInstanceID() const
     return id;
 }
 
+inline GameControllerState GameController::snapshot(const GameControllerState& previous) const
+{
+    SDL_GameController* handle = _resource.getHandle();
+
+    GameControllerState state;
+    for(Button button : ALL_BUTTONS) {
+        if(SDL_GameControllerGetButton(handle, static_cast<SDL_GameControllerButton>(button))) {
+            state.buttons |= GameControllerState::getMask(button);
+        }
+    }
+    for(Axis axis : ALL_AXES) {
+        state.axes[static_cast<std::size_t>(axis)] = SDL_GameControllerGetAxis(handle, static_cast<SDL_GameControllerAxis>(axis));
+    }
+
+    state.updateEdges(previous);
+    return state;
+}
+
+inline GameControllerState GameController::snapshot() const
+{
+    return snapshot(GameControllerState{});
+}
+
+inline std::uint32_t GameControllerState::getMask(GameController::Button button)
+{
+    assert(button > GameController::Button::INVALID && button < GameController::Button::MAX);
+    return std::uint32_t{1} << static_cast<int>(button);
+}
+
+inline void GameControllerState::updateEdges(const GameControllerState& previous)
+{
+    std::uint32_t changed = buttons ^ previous.buttons;
+    pressed = changed & buttons;
+    released = changed & previous.buttons;
+}
+
+inline bool GameControllerState::isDown(GameController::Button button) const
+{
+    return (buttons & getMask(button)) != 0;
+}
+
+inline bool GameControllerState::wasPressed(GameController::Button button) const
+{
+    return (pressed & getMask(button)) != 0;
+}
+
+inline bool GameControllerState::wasReleased(GameController::Button button) const
+{
+    return (released & getMask(button)) != 0;
+}
+
+inline std::int16_t GameControllerState::get(GameController::Axis axis) const
+{
+    assert(axis > GameController::Axis::INVALID && axis < GameController::Axis::MAX);
+    return axes[static_cast<std::size_t>(axis)];
+}
+
+inline float GameControllerState::getFloat(GameController::Axis axis) const
+{
+    return detail::normalizeAxis(get(axis));
+}
+
 } // namespace sdlwrapper
 
 #endif // SDLWRAPPER_GAME_CONTROLLER_HPP
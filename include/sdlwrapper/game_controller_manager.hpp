@@ -0,0 +1,251 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef SDLWRAPPER_GAME_CONTROLLER_MANAGER_HPP
+#define SDLWRAPPER_GAME_CONTROLLER_MANAGER_HPP
+
+#include "sdlwrapper/game_controller.hpp"
+#include "sdlwrapper/sdl.hpp"
+
+#include <SDL.h>
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace sdlwrapper
+{
+
+/**
+ * @brief Owns every open GameController, found by instance ID in constant time.
+ *
+ * Controllers, their instance IDs and their latest snapshots are packed into parallel arrays,
+ * so iterating every controller's state walks one contiguous array.
+ * A sparse array indexed by instance ID maps each controller event to its slot.
+ * Removing a controller moves the last one into its slot, so indices change on hotplug,
+ * while instance IDs never do.
+ */
+class GameControllerManager
+{
+public:
+    static constexpr std::size_t NOT_FOUND = static_cast<std::size_t>(-1);
+
+    /**
+     * @brief Open every game controller attached now.
+     *
+     * @param capacity  Controllers expected at once, reserved up front
+     * @throws SdlError
+     */
+    explicit GameControllerManager(const GameControllerSubsystem&, std::size_t capacity = 16);
+
+    GameControllerManager(const GameControllerManager&) = delete;
+    GameControllerManager& operator=(const GameControllerManager&) = delete;
+
+    /**
+     * @brief Open or close a controller for SDL_CONTROLLERDEVICEADDED or SDL_CONTROLLERDEVICEREMOVED.
+     *
+     * Devices already open, and other event types, are ignored.
+     * @return true if a controller was opened or closed
+     * @throws SdlError if an added controller can't be opened
+     */
+    bool handleEvent(const SDL_ControllerDeviceEvent& event);
+
+    /**
+     * @brief Open the controller at a device index, unless it is already open.
+     * @return Index of the controller
+     * @throws SdlError
+     */
+    std::size_t open(int deviceIndex);
+
+    /**
+     * @brief Close the controller with an instance ID.
+     * @return false if it isn't open
+     */
+    bool close(SDL_JoystickID instanceID);
+
+    /**
+     * @brief Refresh every controller's state, with edges since the last update.
+     */
+    void update();
+
+    std::size_t getSize() const;
+
+    /**
+     * @return Index of the controller, or NOT_FOUND
+     */
+    std::size_t find(SDL_JoystickID instanceID) const;
+
+    GameController& getController(std::size_t index);
+    const GameController& getController(std::size_t index) const;
+
+    /**
+     * @brief Get every controller's instance ID, in index order.
+     */
+    const std::vector<SDL_JoystickID>& getInstanceIDs() const;
+
+    /**
+     * @brief Get every controller's state as of the last update, in index order.
+     */
+    const std::vector<GameControllerState>& getStates() const;
+
+    /**
+     * @return State of the controller, or nullptr if it isn't open
+     */
+    const GameControllerState* findState(SDL_JoystickID instanceID) const;
+
+private:
+    std::size_t add(GameController controller);
+
+    GameControllerSubsystem _subsystem;
+
+    // dense, indexed by slot
+    std::vector<GameController> _controllers;
+    std::vector<SDL_JoystickID> _instanceIDs;
+    std::vector<GameControllerState> _states;
+
+    // sparse, slot + 1 by instance ID, or 0
+    std::vector<std::uint32_t> _slots;
+};
+
+inline GameControllerManager::GameControllerManager(const GameControllerSubsystem& subsystem, std::size_t capacity)
+    : _subsystem(subsystem)
+{
+    _controllers.reserve(capacity);
+    _instanceIDs.reserve(capacity);
+    _states.reserve(capacity);
+    _slots.reserve(capacity);
+
+    for(int i = 0; i < SDL_NumJoysticks(); ++i) {
+        if(SDL_IsGameController(i)) {
+            open(i);
+        }
+    }
+}
+
+inline bool GameControllerManager::handleEvent(const SDL_ControllerDeviceEvent& event)
+{
+    if(event.type == SDL_CONTROLLERDEVICEADDED) {
+        std::size_t size = _controllers.size();
+        open(event.which);
+        return _controllers.size() != size;
+    }
+    if(event.type == SDL_CONTROLLERDEVICEREMOVED) {
+        return close(event.which);
+    }
+    return false;
+}
+
+inline std::size_t GameControllerManager::open(int deviceIndex)
+{
+    // the same joystick hands out the same handle, so opening twice only adds a reference
+    GameController controller {_subsystem, deviceIndex};
+    std::size_t index = find(controller.getInstanceID());
+    if(index != NOT_FOUND) {
+        return index;
+    }
+    return add(std::move(controller));
+}
+
+inline bool GameControllerManager::close(SDL_JoystickID instanceID)
+{
+    std::size_t index = find(instanceID);
+    if(index == NOT_FOUND) {
+        return false;
+    }
+
+    // move the last controller into the hole
+    std::size_t last = _controllers.size() - 1;
+    if(index != last) {
+        _controllers[index] = std::move(_controllers[last]);
+        _instanceIDs[index] = _instanceIDs[last];
+        _states[index] = _states[last];
+        _slots[static_cast<std::size_t>(_instanceIDs[index])] = static_cast<std::uint32_t>(index + 1);
+    }
+    _controllers.pop_back();
+    _instanceIDs.pop_back();
+    _states.pop_back();
+    _slots[static_cast<std::size_t>(instanceID)] = 0;
+    return true;
+}
+
+inline void GameControllerManager::update()
+{
+    for(std::size_t i = 0; i < _controllers.size(); ++i) {
+        _states[i] = _controllers[i].snapshot(_states[i]);
+    }
+}
+
+inline std::size_t GameControllerManager::getSize() const
+{
+    return _controllers.size();
+}
+
+inline std::size_t GameControllerManager::find(SDL_JoystickID instanceID) const
+{
+    if(instanceID < 0 || static_cast<std::size_t>(instanceID) >= _slots.size()) {
+        return NOT_FOUND;
+    }
+    // an empty slot wraps around to NOT_FOUND
+    return static_cast<std::size_t>(_slots[static_cast<std::size_t>(instanceID)]) - 1;
+}
+
+inline GameController& GameControllerManager::getController(std::size_t index)
+{
+    assert(index < _controllers.size());
+    return _controllers[index];
+}
+
+inline const GameController& GameControllerManager::getController(std::size_t index) const
+{
+    assert(index < _controllers.size());
+    return _controllers[index];
+}
+
+inline const std::vector<SDL_JoystickID>& GameControllerManager::getInstanceIDs() const
+{
+    return _instanceIDs;
+}
+
+inline const std::vector<GameControllerState>& GameControllerManager::getStates() const
+{
+    return _states;
+}
+
+inline const GameControllerState* GameControllerManager::findState(SDL_JoystickID instanceID) const
+{
+    std::size_t index = find(instanceID);
+    return index != NOT_FOUND ? &_states[index] : nullptr;
+}
+
+inline std::size_t GameControllerManager::add(GameController controller)
+{
+    SDL_JoystickID instanceID = controller.getInstanceID();
+
+    // instance IDs count up from 0 as devices are plugged in, so the index stays small
+    if(static_cast<std::size_t>(instanceID) >= _slots.size()) {
+        _slots.resize(static_cast<std::size_t>(instanceID) + 1, 0);
+    }
+
+    std::size_t index = _controllers.size();
+    _controllers.push_back(std::move(controller));
+    _instanceIDs.push_back(instanceID);
+    _states.push_back(_controllers.back().snapshot());
+    _slots[static_cast<std::size_t>(instanceID)] = static_cast<std::uint32_t>(index + 1);
+    return index;
+}
+
+} // namespace sdlwrapper
+
+#endif // SDLWRAPPER_GAME_CONTROLLER_MANAGER_HPP
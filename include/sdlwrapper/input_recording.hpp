@@ -0,0 +1,435 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef SDLWRAPPER_INPUT_RECORDING_HPP
+#define SDLWRAPPER_INPUT_RECORDING_HPP
+
+#include "sdlwrapper/game_controller.hpp"
+#include "sdlwrapper/sdl_error.hpp"
+#include "sdlwrapper/sdl.hpp"
+#include "sdlwrapper/detail/rwops.hpp"
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace sdlwrapper
+{
+
+/**
+ * @brief Writes one GameControllerState per frame to a file, delta encoded.
+ *
+ * Each frame stores only the buttons and axes which changed, and runs of unchanged frames
+ * take one byte per 128 frames, so an hour of play at 60 Hz is typically well under a megabyte.
+ * Record one file per controller.
+ */
+class InputRecorder
+{
+public:
+    /**
+     * @throws SdlError if the file can't be created
+     */
+    explicit InputRecorder(const char* fileName);
+
+    InputRecorder(const InputRecorder&) = delete;
+    InputRecorder& operator=(const InputRecorder&) = delete;
+
+    /**
+     * @brief Write anything still buffered, ignoring errors. Call flush() first to see them.
+     */
+    ~InputRecorder();
+
+    /**
+     * @brief Append the next frame. Edges are not stored, the player recomputes them.
+     * @throws SdlError if a full buffer can't be written
+     */
+    void record(const GameControllerState& state);
+
+    /**
+     * @brief Write every frame recorded so far to the file.
+     * @throws SdlError
+     */
+    void flush();
+
+    std::uint64_t getFrames() const;
+
+    /**
+     * @brief Get the encoded size of every frame recorded so far, including the file header.
+     */
+    std::uint64_t getSizeBytes() const;
+
+private:
+    void writeIdle();
+
+    std::unique_ptr<SDL_RWops, detail::RWopsDeleter> _rw;
+    std::vector<std::uint8_t> _buffer;
+    GameControllerState _previous {};
+    std::uint32_t _idle {};
+    std::uint64_t _frames {};
+    std::uint64_t _written {};
+};
+
+/**
+ * @brief Reads the frames written by an InputRecorder, in order.
+ */
+class InputPlayer
+{
+public:
+    /**
+     * @brief Load a whole recording into memory.
+     * @throws SdlError if the file can't be read, or isn't a recording
+     */
+    explicit InputPlayer(const char* fileName);
+
+    /**
+     * @brief Decode the next frame, with pressed and released edges since the last one.
+     * @return false once every frame has been played, leaving state unchanged
+     * @throws SdlError if the recording is truncated
+     */
+    bool next(GameControllerState& state);
+
+    /**
+     * @brief Go back to the first frame.
+     */
+    void rewind();
+
+    /**
+     * @brief Get the number of frames played since the start.
+     */
+    std::uint64_t getFrame() const;
+
+private:
+    std::uint8_t readByte();
+    std::uint32_t readVarint();
+
+    std::vector<std::uint8_t> _data;
+    std::size_t _position {};
+    GameControllerState _state {};
+    std::uint32_t _idle {};
+    std::uint64_t _frame {};
+};
+
+#if SDL_VERSION_ATLEAST(2, 0, 14)
+/**
+ * @brief A headless game controller, driven by replayed states instead of hardware.
+ *
+ * Open a GameController on getDeviceIndex() to read it back through the usual API,
+ * after SDL_GameControllerUpdate() or the next event pump.
+ * Trigger values round trip to within one step, through SDL's axis mapping.
+ */
+class VirtualGameController
+{
+public:
+    /**
+     * @throws SdlError if virtual joysticks aren't supported
+     */
+    explicit VirtualGameController(const GameControllerSubsystem&);
+
+    VirtualGameController(const VirtualGameController&) = delete;
+    VirtualGameController& operator=(const VirtualGameController&) = delete;
+
+    ~VirtualGameController();
+
+    /**
+     * @brief Get the current device index, which changes as other joysticks are removed.
+     */
+    int getDeviceIndex() const;
+
+    SDL_JoystickID getInstanceID() const;
+
+    /**
+     * @brief Set every button and axis.
+     * @throws SdlError
+     */
+    void apply(const GameControllerState& state);
+
+private:
+    SDL_Joystick* _joystick;
+    SDL_JoystickID _instanceID;
+};
+#endif // SDL_VERSION_ATLEAST(2, 0, 14)
+
+namespace detail
+{
+
+constexpr char INPUT_RECORDING_MAGIC[8] = {'S', 'D', 'L', 'W', 'I', 'N', 'P', '1'};
+
+// a byte with this bit set is a run of (byte & 0x7F) + 1 unchanged frames,
+// otherwise bit 0 flags a button mask XOR, and bits 1 to 6 flag changed axes,
+// which follow as varints in that order
+constexpr std::uint8_t INPUT_IDLE_RUN = 0x80;
+constexpr std::uint32_t INPUT_MAX_IDLE_RUN = 128;
+
+// flushed to the file whenever this much is buffered
+constexpr std::size_t INPUT_BUFFER_BYTES = 64 * 1024;
+
+inline void writeVarint(std::vector<std::uint8_t>& buffer, std::uint32_t value)
+{
+    while(value >= 0x80) {
+        buffer.push_back(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back(static_cast<std::uint8_t>(value));
+}
+
+// small deltas either way fit in one byte
+inline std::uint32_t zigzag(std::int32_t value)
+{
+    return (static_cast<std::uint32_t>(value) << 1) ^ static_cast<std::uint32_t>(value >> 31);
+}
+
+inline std::int32_t unzigzag(std::uint32_t value)
+{
+    return static_cast<std::int32_t>(value >> 1) ^ -static_cast<std::int32_t>(value & 1);
+}
+
+} // namespace detail
+
+inline InputRecorder::InputRecorder(const char* fileName)
+    : _rw(SDL_RWFromFile(fileName, "wb"))
+{
+    if(!_rw) {
+        throw SdlError{};
+    }
+    _buffer.reserve(detail::INPUT_BUFFER_BYTES + 32);
+    _buffer.insert(_buffer.end(), std::begin(detail::INPUT_RECORDING_MAGIC), std::end(detail::INPUT_RECORDING_MAGIC));
+    _written = _buffer.size();
+}
+
+inline InputRecorder::~InputRecorder()
+{
+    writeIdle();
+    SDL_RWwrite(_rw.get(), _buffer.data(), 1, _buffer.size());
+}
+
+inline void InputRecorder::record(const GameControllerState& state)
+{
+    ++_frames;
+
+    std::uint8_t flags = state.buttons != _previous.buttons ? 1 : 0;
+    for(std::size_t i = 0; i < state.axes.size(); ++i) {
+        if(state.axes[i] != _previous.axes[i]) {
+            flags |= static_cast<std::uint8_t>(2 << i);
+        }
+    }
+
+    if(flags == 0) {
+        if(++_idle == detail::INPUT_MAX_IDLE_RUN) {
+            writeIdle();
+        }
+        return;
+    }
+    writeIdle();
+
+    std::size_t size = _buffer.size();
+    _buffer.push_back(flags);
+    if((flags & 1) != 0) {
+        // every bit, since newer SDL versions have more than 16 buttons
+        detail::writeVarint(_buffer, state.buttons ^ _previous.buttons);
+    }
+    for(std::size_t i = 0; i < state.axes.size(); ++i) {
+        if((flags & (2 << i)) != 0) {
+            detail::writeVarint(_buffer, detail::zigzag(state.axes[i] - _previous.axes[i]));
+        }
+    }
+    _written += _buffer.size() - size;
+
+    _previous.buttons = state.buttons;
+    _previous.axes = state.axes;
+
+    if(_buffer.size() >= detail::INPUT_BUFFER_BYTES) {
+        flush();
+    }
+}
+
+inline void InputRecorder::flush()
+{
+    writeIdle();
+    if(SDL_RWwrite(_rw.get(), _buffer.data(), 1, _buffer.size()) != _buffer.size()) {
+        throw SdlError{};
+    }
+    _buffer.clear();
+}
+
+inline std::uint64_t InputRecorder::getFrames() const
+{
+    return _frames;
+}
+
+inline std::uint64_t InputRecorder::getSizeBytes() const
+{
+    return _written + (_idle > 0 ? 1 : 0);
+}
+
+inline void InputRecorder::writeIdle()
+{
+    if(_idle > 0) {
+        _buffer.push_back(static_cast<std::uint8_t>(detail::INPUT_IDLE_RUN | (_idle - 1)));
+        ++_written;
+        _idle = 0;
+    }
+}
+
+inline InputPlayer::InputPlayer(const char* fileName)
+{
+    std::unique_ptr<SDL_RWops, detail::RWopsDeleter> rw {SDL_RWFromFile(fileName, "rb")};
+    if(!rw) {
+        throw SdlError{};
+    }
+
+    Sint64 size = SDL_RWsize(rw.get());
+    _data.resize(static_cast<std::size_t>(std::max<Sint64>(size, 0)));
+    _data.resize(SDL_RWread(rw.get(), _data.data(), 1, _data.size()));
+
+    if(_data.size() < sizeof(detail::INPUT_RECORDING_MAGIC) || std::memcmp(_data.data(), detail::INPUT_RECORDING_MAGIC, sizeof(detail::INPUT_RECORDING_MAGIC)) != 0) {
+        SDL_SetError("Input recording: bad header");
+        throw SdlError{};
+    }
+    rewind();
+}
+
+inline bool InputPlayer::next(GameControllerState& state)
+{
+    if(_idle == 0) {
+        if(_position == _data.size()) {
+            return false;
+        }
+
+        std::uint8_t flags = readByte();
+        if((flags & detail::INPUT_IDLE_RUN) != 0) {
+            _idle = (flags & ~detail::INPUT_IDLE_RUN) + 1u;
+        }
+        else {
+            if((flags & 1) != 0) {
+                _state.buttons ^= readVarint();
+            }
+            for(std::size_t i = 0; i < _state.axes.size(); ++i) {
+                if((flags & (2 << i)) != 0) {
+                    _state.axes[i] = static_cast<std::int16_t>(_state.axes[i] + detail::unzigzag(readVarint()));
+                }
+            }
+            _idle = 1;
+        }
+    }
+    --_idle;
+    ++_frame;
+
+    GameControllerState previous = state;
+    state.buttons = _state.buttons;
+    state.axes = _state.axes;
+    state.updateEdges(previous);
+    return true;
+}
+
+inline void InputPlayer::rewind()
+{
+    _position = sizeof(detail::INPUT_RECORDING_MAGIC);
+    _state = GameControllerState{};
+    _idle = 0;
+    _frame = 0;
+}
+
+inline std::uint64_t InputPlayer::getFrame() const
+{
+    return _frame;
+}
+
+inline std::uint8_t InputPlayer::readByte()
+{
+    if(_position == _data.size()) {
+        SDL_SetError("Input recording: truncated frame");
+        throw SdlError{};
+    }
+    return _data[_position++];
+}
+
+inline std::uint32_t InputPlayer::readVarint()
+{
+    std::uint32_t value = 0;
+    for(int shift = 0; shift < 35; shift += 7) {
+        std::uint8_t byte = readByte();
+        value |= std::uint32_t{byte & 0x7Fu} << shift;
+        if((byte & 0x80) == 0) {
+            break;
+        }
+    }
+    return value;
+}
+
+#if SDL_VERSION_ATLEAST(2, 0, 14)
+inline VirtualGameController::VirtualGameController(const GameControllerSubsystem&)
+{
+    int deviceIndex = SDL_JoystickAttachVirtual(SDL_JOYSTICK_TYPE_GAMECONTROLLER, SDL_CONTROLLER_AXIS_MAX, SDL_CONTROLLER_BUTTON_MAX, 0);
+    if(deviceIndex < 0) {
+        throw SdlError{};
+    }
+    _joystick = SDL_JoystickOpen(deviceIndex);
+    if(_joystick == nullptr) {
+        SDL_JoystickDetachVirtual(deviceIndex);
+        throw SdlError{};
+    }
+    _instanceID = SDL_JoystickInstanceID(_joystick);
+}
+
+inline VirtualGameController::~VirtualGameController()
+{
+    int deviceIndex = getDeviceIndex();
+    SDL_JoystickClose(_joystick);
+    SDL_JoystickDetachVirtual(deviceIndex);
+}
+
+inline int VirtualGameController::getDeviceIndex() const
+{
+    for(int i = 0; i < SDL_NumJoysticks(); ++i) {
+        if(SDL_JoystickGetDeviceInstanceID(i) == _instanceID) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+inline SDL_JoystickID VirtualGameController::getInstanceID() const
+{
+    return _instanceID;
+}
+
+inline void VirtualGameController::apply(const GameControllerState& state)
+{
+    for(GameController::Button button : GameController::ALL_BUTTONS) {
+        if(SDL_JoystickSetVirtualButton(_joystick, static_cast<int>(button), state.isDown(button) ? SDL_PRESSED : SDL_RELEASED) != 0) {
+            throw SdlError{};
+        }
+    }
+    for(GameController::Axis axis : GameController::ALL_AXES) {
+        std::int32_t value = state.get(axis);
+        // triggers map the joystick's full range onto 0 to 32767
+        if(axis == GameController::Axis::TRIGGERLEFT || axis == GameController::Axis::TRIGGERRIGHT) {
+            value = std::max(value, 0) * 2 - 32768;
+        }
+        if(SDL_JoystickSetVirtualAxis(_joystick, static_cast<int>(axis), static_cast<Sint16>(value)) != 0) {
+            throw SdlError{};
+        }
+    }
+}
+#endif // SDL_VERSION_ATLEAST(2, 0, 14)
+
+} // namespace sdlwrapper
+
+#endif // SDLWRAPPER_INPUT_RECORDING_HPP
@@ -0,0 +1,546 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef SDLWRAPPER_MIXER_HPP
+#define SDLWRAPPER_MIXER_HPP
+
+#include "sdlwrapper/audio.hpp"
+#include "sdlwrapper/wav_cache.hpp"
+#include "sdlwrapper/detail/mpmc_ring_buffer.hpp"
+#include "sdlwrapper/detail/simd.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace sdlwrapper
+{
+
+namespace detail
+{
+
+// left += src * leftGain, right += src * rightGain
+inline void mixAccumulateMono(float* left, float* right, const float* src, std::size_t frames, float leftGain, float rightGain)
+{
+    Float4 leftGain4 = Float4::splat(leftGain);
+    Float4 rightGain4 = Float4::splat(rightGain);
+    std::size_t i = 0;
+    for(; i + Float4::SIZE <= frames; i += Float4::SIZE) {
+        Float4 s = Float4::load(src + i);
+        (Float4::load(left + i) + s * leftGain4).store(left + i);
+        (Float4::load(right + i) + s * rightGain4).store(right + i);
+    }
+    for(; i < frames; ++i) {
+        left[i] += src[i] * leftGain;
+        right[i] += src[i] * rightGain;
+    }
+}
+
+// left += src[even] * leftGain, right += src[odd] * rightGain
+inline void mixAccumulateStereo(float* left, float* right, const float* src, std::size_t frames, float leftGain, float rightGain)
+{
+    Float4 leftGain4 = Float4::splat(leftGain);
+    Float4 rightGain4 = Float4::splat(rightGain);
+    std::size_t i = 0;
+    for(; i + Float4::SIZE <= frames; i += Float4::SIZE) {
+        Float4 l, r;
+        deinterleave(Float4::load(src + i * 2), Float4::load(src + i * 2 + Float4::SIZE), l, r);
+        (Float4::load(left + i) + l * leftGain4).store(left + i);
+        (Float4::load(right + i) + r * rightGain4).store(right + i);
+    }
+    for(; i < frames; ++i) {
+        left[i] += src[i * 2] * leftGain;
+        right[i] += src[i * 2 + 1] * rightGain;
+    }
+}
+
+// clip planar left and right to [-1, 1], and interleave into out
+inline void mixClipInterleave(float* out, const float* left, const float* right, std::size_t frames)
+{
+    Float4 low = Float4::splat(-1.0f);
+    Float4 high = Float4::splat(1.0f);
+    std::size_t i = 0;
+    for(; i + Float4::SIZE <= frames; i += Float4::SIZE) {
+        Float4 l = min(max(Float4::load(left + i), low), high);
+        Float4 r = min(max(Float4::load(right + i), low), high);
+        Float4 first, second;
+        interleave(l, r, first, second);
+        first.store(out + i * 2);
+        second.store(out + i * 2 + Float4::SIZE);
+    }
+    for(; i < frames; ++i) {
+        out[i * 2] = std::min(std::max(left[i], -1.0f), 1.0f);
+        out[i * 2 + 1] = std::min(std::max(right[i], -1.0f), 1.0f);
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Mixes many voices of float samples into a stereo AUDIO_F32SYS stream.
+ *
+ * Voices are started, changed and stopped from any threads,
+ * and reach the audio thread through a lock-free command queue.
+ * The audio thread never allocates or waits.
+ *
+ * Every command may be scheduled for a frame of the mixer's output,
+ * counted from the first frame ever mixed. The mix is split at that frame,
+ * so the command lands on the exact sample whatever the buffer size.
+ * Stopping or changing a voice before its scheduled start cancels or changes the pending start,
+ * and stopAll cancels every start sent before it.
+ *
+ * Commands wait in a buffer of commandCapacity until their frame. While it is full of
+ * commands for later frames, new commands, even for NOW, stay queued until those frames are mixed.
+ *
+ * Sample data is not copied, it must outlive any voice playing it.
+ */
+class Mixer
+{
+public:
+    using VoiceId = std::uint32_t;
+
+    static constexpr VoiceId INVALID_VOICE = ~VoiceId{};
+
+    // frames mixed at a time, sized to keep scratch buffers in L1 cache
+    static constexpr std::size_t BLOCK_FRAMES = 256;
+
+    // schedule a command for the next mix
+    static constexpr std::uint64_t NOW = 0;
+
+    /**
+     * @param maxVoices  Number of voices which can play at once, at most 65535
+     * @param commandCapacity  Number of commands which can wait for the audio thread, and for their frame.
+     *                         Should exceed the commands scheduled ahead at once, or NOW commands wait behind them.
+     */
+    explicit Mixer(std::size_t maxVoices = 256, std::size_t commandCapacity = 1024);
+
+    Mixer(const Mixer&) = delete;
+    Mixer& operator=(const Mixer&) = delete;
+
+    /**
+     * @brief Start a voice. Any thread.
+     *
+     * @param frames  Interleaved float samples
+     * @param frameCount  Length in frames
+     * @param channels  1 for mono or 2 for stereo
+     * @param gain  Linear gain
+     * @param pan  -1.0f (left) to 1.0f (right)
+     * @param loop  Repeat until stopped
+     * @param at  Mixer frame to start on, or NOW. Frames already mixed also mean the next mix.
+     * @return Voice id, or INVALID_VOICE if all voices are busy or the command queue is full
+     */
+    VoiceId play(const float* frames, std::uint32_t frameCount, std::uint8_t channels, float gain = 1.0f, float pan = 0.0f, bool loop = false, std::uint64_t at = NOW);
+
+    /**
+     * @brief Start a voice playing an AUDIO_F32SYS mono or stereo Wav. Any thread.
+     */
+    VoiceId play(const Wav& wav, float gain = 1.0f, float pan = 0.0f, bool loop = false, std::uint64_t at = NOW);
+
+    /**
+     * @brief Start a voice playing an AUDIO_F32SYS mono or stereo AudioAsset. Any thread.
+     *
+     * The mixer does not hold a reference, keep the handle alive while the voice plays.
+     */
+    VoiceId play(const AudioAsset& asset, float gain = 1.0f, float pan = 0.0f, bool loop = false, std::uint64_t at = NOW);
+
+    /**
+     * @brief Stop a voice. Any thread.
+     * @return false if voice is INVALID_VOICE or the command queue is full
+     */
+    bool stop(VoiceId voice, std::uint64_t at = NOW);
+
+    /**
+     * @brief Change the gain and pan of a voice. Any thread.
+     * @return false if voice is INVALID_VOICE or the command queue is full
+     */
+    bool setGain(VoiceId voice, float gain, float pan = 0.0f, std::uint64_t at = NOW);
+
+    /**
+     * @brief Stop every voice, including those sent earlier but scheduled to start later. Any thread.
+     * @return false if the command queue is full
+     */
+    bool stopAll(std::uint64_t at = NOW);
+
+    std::size_t getMaxVoices() const;
+
+    /**
+     * @brief Get the number of voices playing, as of the last mix.
+     */
+    std::size_t getActiveVoices() const;
+
+    /**
+     * @brief Get the number of frames mixed so far, as of the last mix.
+     *
+     * Commands scheduled for this frame plus the device's buffer size will not be late.
+     */
+    std::uint64_t getFramePosition() const;
+
+    /**
+     * @brief Mix all voices into an interleaved stereo stream. Audio thread only.
+     * @param out  Destination, overwritten
+     * @param frames  Length in frames
+     */
+    void mix(float* out, std::size_t frames);
+
+    /**
+     * @brief SDL_AudioCallback for an AUDIO_F32SYS stereo AudioDevice, pass the Mixer as userdata.
+     */
+    static void callback(void* userdata, std::uint8_t* stream, int len);
+
+private:
+    struct Command
+    {
+        enum class Type : std::uint8_t
+        {
+            PLAY,
+            STOP,
+            SET_GAIN,
+            STOP_ALL
+        };
+
+        Type type;
+        std::uint8_t channels;
+        bool loop;
+        VoiceId voice;
+        const float* frames;
+        std::uint32_t frameCount;
+        float gain;
+        float pan;
+        std::uint64_t frame;
+        // order the audio thread received it in
+        std::uint64_t sequence;
+    };
+
+    void execute(const Command& command, std::size_t pending);
+    void cancel(const Command& command, std::size_t pending);
+    void release(std::size_t index);
+    void mixBlock(float* out, std::size_t frames);
+
+    static std::uint32_t getSlot(VoiceId voice);
+
+    // each slot's generation is only touched by the thread which popped the slot
+    std::vector<std::uint16_t> _generations;
+
+    // any thread to audio thread
+    detail::MpmcRingBuffer<Command> _commands;
+
+    // audio thread to any thread
+    detail::MpmcRingBuffer<std::uint32_t> _freeSlots;
+
+    // audio thread commands waiting for their frame, in frame order
+    std::vector<Command> _scheduled;
+    std::uint64_t _sequence {};
+    std::uint64_t _frame {};
+    std::atomic<std::uint64_t> _publishedFrame {};
+
+    // audio thread voice table, structure of arrays indexed by slot
+    std::vector<VoiceId> _voiceIds;
+    std::vector<const float*> _voiceFrames;
+    std::vector<std::uint32_t> _voiceFrameCounts;
+    std::vector<std::uint32_t> _voicePositions;
+    std::vector<float> _voiceLeftGains;
+    std::vector<float> _voiceRightGains;
+    std::vector<std::uint8_t> _voiceChannels;
+    std::vector<std::uint8_t> _voiceLoops;
+
+    // densely packed slots of playing voices
+    std::vector<std::uint32_t> _active;
+    std::size_t _numActive {};
+    std::atomic<std::size_t> _publishedActive {};
+
+    std::vector<float> _left;
+    std::vector<float> _right;
+};
+
+inline Mixer::Mixer(std::size_t maxVoices, std::size_t commandCapacity)
+    : _generations(maxVoices),
+      _commands(commandCapacity),
+      _freeSlots(maxVoices),
+      _voiceIds(maxVoices, INVALID_VOICE),
+      _voiceFrames(maxVoices),
+      _voiceFrameCounts(maxVoices),
+      _voicePositions(maxVoices),
+      _voiceLeftGains(maxVoices),
+      _voiceRightGains(maxVoices),
+      _voiceChannels(maxVoices),
+      _voiceLoops(maxVoices),
+      _active(maxVoices),
+      _left(BLOCK_FRAMES),
+      _right(BLOCK_FRAMES)
+{
+    assert(maxVoices > 0 && maxVoices <= 0xFFFF);
+
+    for(std::size_t i = 0; i < maxVoices; ++i) {
+        _freeSlots.push(static_cast<std::uint32_t>(i));
+    }
+    _scheduled.reserve(commandCapacity);
+}
+
+inline Mixer::VoiceId Mixer::play(const float* frames, std::uint32_t frameCount, std::uint8_t channels, float gain, float pan, bool loop, std::uint64_t at)
+{
+    assert(channels == 1 || channels == 2);
+
+    std::uint32_t slot;
+    if(!_freeSlots.pop(slot)) {
+        return INVALID_VOICE;
+    }
+
+    // the previous owner's increment reached this thread through the free list
+    VoiceId voice = static_cast<VoiceId>(++_generations[slot]) << 16 | slot;
+    if(!_commands.push(Command{Command::Type::PLAY, channels, loop, voice, frames, frameCount, gain, pan, at, 0})) {
+        _freeSlots.push(slot);
+        return INVALID_VOICE;
+    }
+    return voice;
+}
+
+inline Mixer::VoiceId Mixer::play(const Wav& wav, float gain, float pan, bool loop, std::uint64_t at)
+{
+    assert(wav.getAudioFormat() == AUDIO_F32SYS);
+    std::uint32_t frameCount = wav.getSizeBytes() / (sizeof(float) * wav.getChannels());
+    return play(reinterpret_cast<const float*>(wav.begin()), frameCount, wav.getChannels(), gain, pan, loop, at);
+}
+
+inline Mixer::VoiceId Mixer::play(const AudioAsset& asset, float gain, float pan, bool loop, std::uint64_t at)
+{
+    assert(asset.getAudioFormat() == AUDIO_F32SYS);
+    std::uint32_t frameCount = asset.getSizeBytes() / (sizeof(float) * asset.getChannels());
+    return play(reinterpret_cast<const float*>(asset.begin()), frameCount, asset.getChannels(), gain, pan, loop, at);
+}
+
+inline bool Mixer::stop(VoiceId voice, std::uint64_t at)
+{
+    if(voice == INVALID_VOICE) {
+        return false;
+    }
+    return _commands.push(Command{Command::Type::STOP, 0, false, voice, nullptr, 0, 0.0f, 0.0f, at, 0});
+}
+
+inline bool Mixer::setGain(VoiceId voice, float gain, float pan, std::uint64_t at)
+{
+    if(voice == INVALID_VOICE) {
+        return false;
+    }
+    return _commands.push(Command{Command::Type::SET_GAIN, 0, false, voice, nullptr, 0, gain, pan, at, 0});
+}
+
+inline bool Mixer::stopAll(std::uint64_t at)
+{
+    return _commands.push(Command{Command::Type::STOP_ALL, 0, false, INVALID_VOICE, nullptr, 0, 0.0f, 0.0f, at, 0});
+}
+
+inline std::size_t Mixer::getMaxVoices() const
+{
+    return _voiceIds.size();
+}
+
+inline std::size_t Mixer::getActiveVoices() const
+{
+    return _publishedActive.load(std::memory_order_relaxed);
+}
+
+inline std::uint64_t Mixer::getFramePosition() const
+{
+    return _publishedFrame.load(std::memory_order_relaxed);
+}
+
+inline void Mixer::mix(float* out, std::size_t frames)
+{
+    // sort new commands in by frame, after earlier commands for the same frame
+    Command command;
+    while(_scheduled.size() < _scheduled.capacity() && _commands.pop(command)) {
+        // NOW and frames already mixed all mean the next frame, in the order they were sent
+        command.frame = std::max(command.frame, _frame);
+        command.sequence = _sequence++;
+        auto at = std::upper_bound(_scheduled.begin(), _scheduled.end(), command.frame, [](std::uint64_t frame, const Command& scheduled) {
+            return frame < scheduled.frame;
+        });
+        _scheduled.insert(at, command);
+    }
+
+    std::size_t executed = 0;
+    while(true) {
+        while(executed < _scheduled.size() && _scheduled[executed].frame <= _frame) {
+            // copied, since executing may erase later commands
+            Command next = _scheduled[executed++];
+            execute(next, executed);
+        }
+        if(frames == 0) {
+            break;
+        }
+
+        // stop short of the next scheduled command
+        std::size_t blockFrames = std::min(frames, BLOCK_FRAMES);
+        if(executed < _scheduled.size()) {
+            blockFrames = static_cast<std::size_t>(std::min<std::uint64_t>(blockFrames, _scheduled[executed].frame - _frame));
+        }
+        mixBlock(out, blockFrames);
+        out += blockFrames * 2;
+        frames -= blockFrames;
+        _frame += blockFrames;
+    }
+    _scheduled.erase(_scheduled.begin(), _scheduled.begin() + executed);
+
+    _publishedActive.store(_numActive, std::memory_order_relaxed);
+    _publishedFrame.store(_frame, std::memory_order_relaxed);
+}
+
+inline void Mixer::callback(void* userdata, std::uint8_t* stream, int len)
+{
+    reinterpret_cast<Mixer*>(userdata)->mix(reinterpret_cast<float*>(stream), len / (sizeof(float) * 2));
+}
+
+// pending is the index of the first command in _scheduled not executed yet
+inline void Mixer::execute(const Command& command, std::size_t pending)
+{
+    if(command.type == Command::Type::STOP_ALL) {
+        while(_numActive > 0) {
+            release(_numActive - 1);
+        }
+
+        // and every voice sent before it which hasn't started yet
+        auto end = std::remove_if(_scheduled.begin() + pending, _scheduled.end(), [&](const Command& scheduled) {
+            if(scheduled.type != Command::Type::PLAY || scheduled.sequence > command.sequence) {
+                return false;
+            }
+            _freeSlots.push(getSlot(scheduled.voice));
+            return true;
+        });
+        _scheduled.erase(end, _scheduled.end());
+        return;
+    }
+
+    std::uint32_t slot = getSlot(command.voice);
+    if(slot >= _voiceIds.size()) {
+        // never handed out by play
+        return;
+    }
+    if(command.type == Command::Type::PLAY) {
+        _voiceIds[slot] = command.voice;
+        _voiceFrames[slot] = command.frames;
+        _voiceFrameCounts[slot] = command.frameCount;
+        _voicePositions[slot] = 0;
+        _voiceChannels[slot] = command.channels;
+        _voiceLoops[slot] = command.loop;
+        _active[_numActive++] = slot;
+    }
+    else if(_voiceIds[slot] != command.voice) {
+        // the voice hasn't started yet, or already finished and may have been replaced
+        cancel(command, pending);
+        return;
+    }
+
+    if(command.type == Command::Type::STOP) {
+        std::size_t index = std::find(_active.begin(), _active.begin() + _numActive, slot) - _active.begin();
+        release(index);
+        return;
+    }
+
+    // PLAY or SET_GAIN
+    float pan = std::min(std::max(command.pan, -1.0f), 1.0f);
+    if(_voiceChannels[slot] == 1) {
+        // constant power pan
+        float angle = (pan + 1.0f) * static_cast<float>(M_PI) / 4.0f;
+        _voiceLeftGains[slot] = command.gain * std::cos(angle);
+        _voiceRightGains[slot] = command.gain * std::sin(angle);
+    }
+    else {
+        // stereo balance
+        _voiceLeftGains[slot] = command.gain * std::min(1.0f, 1.0f - pan);
+        _voiceRightGains[slot] = command.gain * std::min(1.0f, 1.0f + pan);
+    }
+}
+
+// apply a STOP or SET_GAIN to its voice's PLAY, if that is still scheduled
+inline void Mixer::cancel(const Command& command, std::size_t pending)
+{
+    auto play = std::find_if(_scheduled.begin() + pending, _scheduled.end(), [&](const Command& scheduled) {
+        return scheduled.type == Command::Type::PLAY && scheduled.voice == command.voice;
+    });
+    if(play == _scheduled.end()) {
+        return;
+    }
+
+    if(command.type == Command::Type::STOP) {
+        _scheduled.erase(play);
+        _freeSlots.push(getSlot(command.voice));
+    }
+    else {
+        play->gain = command.gain;
+        play->pan = command.pan;
+    }
+}
+
+inline void Mixer::release(std::size_t index)
+{
+    std::uint32_t slot = _active[index];
+    _voiceIds[slot] = INVALID_VOICE;
+    _active[index] = _active[--_numActive];
+
+    // capacity matches the voice table, so this never fails
+    _freeSlots.push(slot);
+}
+
+inline void Mixer::mixBlock(float* out, std::size_t frames)
+{
+    std::fill(_left.begin(), _left.begin() + frames, 0.0f);
+    std::fill(_right.begin(), _right.begin() + frames, 0.0f);
+
+    for(std::size_t i = 0; i < _numActive;) {
+        std::uint32_t slot = _active[i];
+        const float* src = _voiceFrames[slot];
+        std::uint32_t frameCount = _voiceFrameCounts[slot];
+        std::uint32_t position = _voicePositions[slot];
+        std::uint8_t channels = _voiceChannels[slot];
+
+        std::size_t mixed = 0;
+        while(mixed < frames && position < frameCount) {
+            std::size_t n = std::min<std::size_t>(frames - mixed, frameCount - position);
+            if(channels == 1) {
+                detail::mixAccumulateMono(_left.data() + mixed, _right.data() + mixed, src + position, n, _voiceLeftGains[slot], _voiceRightGains[slot]);
+            }
+            else {
+                detail::mixAccumulateStereo(_left.data() + mixed, _right.data() + mixed, src + position * 2, n, _voiceLeftGains[slot], _voiceRightGains[slot]);
+            }
+            mixed += n;
+            position += static_cast<std::uint32_t>(n);
+            if(position == frameCount && _voiceLoops[slot]) {
+                position = 0;
+            }
+        }
+
+        if(position >= frameCount) {
+            release(i);
+        }
+        else {
+            _voicePositions[slot] = position;
+            ++i;
+        }
+    }
+
+    detail::mixClipInterleave(out, _left.data(), _right.data(), frames);
+}
+
+inline std::uint32_t Mixer::getSlot(VoiceId voice)
+{
+    return voice & 0xFFFF;
+}
+
+} // namespace sdlwrapper
+
+#endif // SDLWRAPPER_MIXER_HPP
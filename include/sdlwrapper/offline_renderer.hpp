@@ -0,0 +1,231 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef SDLWRAPPER_OFFLINE_RENDERER_HPP
+#define SDLWRAPPER_OFFLINE_RENDERER_HPP
+
+#include "sdlwrapper/audio_rt_check.hpp"
+#include "sdlwrapper/sdl_error.hpp"
+#include "sdlwrapper/detail/simd.hpp"
+#include "sdlwrapper/detail/thread_pool.hpp"
+#include "sdlwrapper/detail/wav_header.hpp"
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace sdlwrapper
+{
+
+namespace detail
+{
+
+// dst += src
+inline void accumulateSamples(float* dst, const float* src, std::size_t count)
+{
+    std::size_t i = 0;
+    for(; i + Float4::SIZE <= count; i += Float4::SIZE) {
+        (Float4::load(dst + i) + Float4::load(src + i)).store(dst + i);
+    }
+    for(; i < count; ++i) {
+        dst[i] += src[i];
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Runs audio callbacks as fast as possible, with no device, and sums them.
+ *
+ * Each track is an independent SDL_AudioCallback producing AUDIO_F32SYS samples,
+ * such as Mixer::callback or EffectGraph::callback.
+ * Tracks render in parallel on a thread pool, each called with spec.samples frames at a time
+ * just as a device would, so the same code produces the same audio online and offline.
+ * When a render ends mid-callback, the rest of that callback's frames start the next render.
+ *
+ * Tracks are summed in the order they were added, so the result is identical for any number of threads.
+ */
+class OfflineRenderer
+{
+public:
+    // frames rendered by every track before summing, a multiple of spec.samples
+    static constexpr std::size_t SEGMENT_FRAMES = 16384;
+
+    /**
+     * @param spec  freq, channels and samples (frames per callback) of the virtual device, format must be AUDIO_F32SYS
+     * @param threads  Number of worker threads, or 0 for one per core
+     */
+    explicit OfflineRenderer(const SDL_AudioSpec& spec, std::size_t threads = 0);
+
+    OfflineRenderer(const OfflineRenderer&) = delete;
+    OfflineRenderer& operator=(const OfflineRenderer&) = delete;
+
+    /**
+     * @brief Add a track. Its callback is only ever called by one thread at a time.
+     */
+    void addTrack(SDL_AudioCallback callback, void* userdata);
+
+    /**
+     * @brief Render the next frames of every track, and sum them into out.
+     * @param out  Interleaved float samples, overwritten
+     */
+    void render(float* out, std::size_t frames);
+
+    /**
+     * @brief Render the next frames into a 32 bit float WAV file.
+     * @throws SdlError
+     */
+    void renderToWav(const char* fileName, std::size_t frames);
+
+    const SDL_AudioSpec& getSpec() const;
+
+    std::size_t getThreads() const;
+
+private:
+    struct Track
+    {
+        SDL_AudioCallback callback;
+        void* userdata;
+        std::vector<float> buffer;
+        // one callback's frames, of which the last leftoverFrames are not rendered yet
+        std::vector<float> leftover;
+        std::size_t leftoverFrames;
+    };
+
+    void renderTrack(Track& track, std::size_t frames);
+
+    SDL_AudioSpec _spec;
+    std::size_t _segmentFrames;
+    std::vector<Track> _tracks {};
+    detail::ThreadPool _pool;
+};
+
+inline OfflineRenderer::OfflineRenderer(const SDL_AudioSpec& spec, std::size_t threads)
+    : _spec(spec),
+      _segmentFrames(std::max<std::size_t>(SEGMENT_FRAMES / std::max<std::uint16_t>(spec.samples, 1), 1) * std::max<std::uint16_t>(spec.samples, 1)),
+      _pool(threads)
+{
+    assert(spec.format == AUDIO_F32SYS);
+    assert(spec.freq > 0 && spec.channels > 0 && spec.samples > 0);
+}
+
+inline void OfflineRenderer::addTrack(SDL_AudioCallback callback, void* userdata)
+{
+    assert(callback != nullptr);
+    _tracks.push_back(Track{callback, userdata, std::vector<float>(_segmentFrames * _spec.channels), std::vector<float>(_spec.samples * _spec.channels), 0});
+}
+
+inline void OfflineRenderer::render(float* out, std::size_t frames)
+{
+    while(frames > 0) {
+        std::size_t segmentFrames = std::min(frames, _segmentFrames);
+        std::size_t segmentSamples = segmentFrames * _spec.channels;
+
+        _pool.parallelFor(_tracks.size(), [&](std::size_t i) {
+            renderTrack(_tracks[i], segmentFrames);
+        });
+
+        // sum slices of the segment in parallel, each in track order
+        constexpr std::size_t SLICE_SAMPLES = 4096;
+        _pool.parallelFor((segmentSamples + SLICE_SAMPLES - 1) / SLICE_SAMPLES, [&](std::size_t slice) {
+            std::size_t begin = slice * SLICE_SAMPLES;
+            std::size_t count = std::min(SLICE_SAMPLES, segmentSamples - begin);
+            std::fill(out + begin, out + begin + count, 0.0f);
+            for(const Track& track : _tracks) {
+                detail::accumulateSamples(out + begin, track.buffer.data() + begin, count);
+            }
+        });
+
+        out += segmentSamples;
+        frames -= segmentFrames;
+    }
+}
+
+inline void OfflineRenderer::renderToWav(const char* fileName, std::size_t frames)
+{
+    std::uint64_t dataSize = std::uint64_t{frames} * _spec.channels * sizeof(float);
+    if(dataSize > 0xFFFFFFFFu - 36) {
+        detail::throwWavError("longer than 4 GiB");
+    }
+
+    std::unique_ptr<SDL_RWops, detail::RWopsDeleter> rw {SDL_RWFromFile(fileName, "wb")};
+    if(!rw) {
+        throw SdlError{};
+    }
+    detail::writeWavHeader(rw.get(), _spec.freq, AUDIO_F32LSB, _spec.channels, static_cast<std::uint32_t>(dataSize));
+
+    std::vector<float> segment(_segmentFrames * _spec.channels);
+    while(frames > 0) {
+        std::size_t segmentFrames = std::min(frames, _segmentFrames);
+        std::size_t segmentSamples = segmentFrames * _spec.channels;
+        render(segment.data(), segmentFrames);
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+        for(std::size_t i = 0; i < segmentSamples; ++i) {
+            segment[i] = SDL_SwapFloatLE(segment[i]);
+        }
+#endif
+        if(SDL_RWwrite(rw.get(), segment.data(), sizeof(float), segmentSamples) != segmentSamples) {
+            detail::throwWavError("write failed");
+        }
+        frames -= segmentFrames;
+    }
+}
+
+inline const SDL_AudioSpec& OfflineRenderer::getSpec() const
+{
+    return _spec;
+}
+
+inline std::size_t OfflineRenderer::getThreads() const
+{
+    return _pool.getThreads();
+}
+
+inline void OfflineRenderer::renderTrack(Track& track, std::size_t frames)
+{
+#ifdef SDLWRAPPER_AUDIO_RT_CHECK
+    detail::AudioThreadScope scope;
+#endif // SDLWRAPPER_AUDIO_RT_CHECK
+
+    std::size_t channels = _spec.channels;
+    int callbackBytes = static_cast<int>(track.leftover.size() * sizeof(float));
+
+    // the end of the last render's final callback
+    std::size_t done = std::min(frames, track.leftoverFrames);
+    auto leftover = track.leftover.end() - track.leftoverFrames * channels;
+    std::copy(leftover, leftover + done * channels, track.buffer.begin());
+    track.leftoverFrames -= done;
+
+    // whole callbacks straight into the buffer
+    for(; done + _spec.samples <= frames; done += _spec.samples) {
+        track.callback(track.userdata, reinterpret_cast<std::uint8_t*>(track.buffer.data() + done * channels), callbackBytes);
+    }
+
+    // a whole callback for the rest, keeping what isn't used for next time
+    if(done < frames) {
+        track.callback(track.userdata, reinterpret_cast<std::uint8_t*>(track.leftover.data()), callbackBytes);
+        std::size_t n = frames - done;
+        std::copy(track.leftover.begin(), track.leftover.begin() + n * channels, track.buffer.begin() + done * channels);
+        track.leftoverFrames = _spec.samples - n;
+    }
+}
+
+} // namespace sdlwrapper
+
+#endif // SDLWRAPPER_OFFLINE_RENDERER_HPP
@@ -0,0 +1,269 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef SDLWRAPPER_QUEUE_STREAMER_HPP
+#define SDLWRAPPER_QUEUE_STREAMER_HPP
+
+#include "sdlwrapper/audio.hpp"
+#include "sdlwrapper/audio_clock.hpp"
+#include "sdlwrapper/sdl_error.hpp"
+
+#ifdef SDLWRAPPER_AUDIO_SUPPORTS_NONCALLBACK
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace sdlwrapper
+{
+
+/**
+ * @brief Feeds a non-callback output device from a producer thread, between two latency watermarks.
+ *
+ * Whenever the device's queue falls below the low watermark, the thread tops it up to the high watermark.
+ * It then sleeps until the queue is expected to reach the low watermark again,
+ * using the drain rate measured between polls, so batches follow the device's real consumption.
+ *
+ * The device should be played and paused normally, but not queued or cleared by anyone else while streaming.
+ *
+ * If queueing fails, the error is counted and kept for getLastError,
+ * and the same batch is queued again at the next poll.
+ */
+class QueueStreamer
+{
+public:
+    /**
+     * @brief Produces up to len bytes of samples in the device's format, on the streamer thread.
+     * @return Number of bytes produced, fewer than len if no more are available yet
+     */
+    using Source = std::function<std::uint32_t(std::uint8_t* data, std::uint32_t len)>;
+
+    /**
+     * @param device  Non-callback output device, must outlive the streamer
+     * @param lowWatermarkMs  Audio queued ahead before topping up
+     * @param highWatermarkMs  Audio queued ahead after topping up
+     * @param clock  Advanced on the streamer thread at every poll, or nullptr. Must outlive the streamer.
+     */
+    QueueStreamer(AudioDevice& device, Source source, std::uint32_t lowWatermarkMs, std::uint32_t highWatermarkMs, AudioClock* clock = nullptr);
+
+    QueueStreamer(const QueueStreamer&) = delete;
+    QueueStreamer& operator=(const QueueStreamer&) = delete;
+
+    ~QueueStreamer();
+
+    /**
+     * @brief Get the audio queued ahead of the device at the last poll, in microseconds.
+     */
+    std::uint32_t getLatency() const;
+
+    /**
+     * @brief Get the number of polls which found the queue empty while playing.
+     */
+    std::uint64_t getUnderruns() const;
+
+    /**
+     * @brief Get the size of the last batch queued, in bytes.
+     */
+    std::uint32_t getBatchSize() const;
+
+    /**
+     * @brief Get the measured drain rate of the device, in bytes per second.
+     */
+    double getDrainRate() const;
+
+    /**
+     * @brief Get the number of batches which failed to queue.
+     */
+    std::uint64_t getErrors() const;
+
+    /**
+     * @brief Get the message of the last batch which failed to queue, or an empty string.
+     */
+    std::string getLastError() const;
+
+private:
+    void run();
+
+    std::uint32_t toBytes(std::uint32_t milliseconds) const;
+
+    AudioDevice& _device;
+    Source _source;
+    AudioClock* _clock;
+    std::uint32_t _frameSize;
+    std::uint32_t _bytesPerSecond;
+    std::uint32_t _lowBytes;
+    std::uint32_t _highBytes;
+    std::unique_ptr<std::uint8_t[]> _buffer;
+
+    std::atomic<std::uint32_t> _latency {};
+    std::atomic<std::uint64_t> _underruns {};
+    std::atomic<std::uint32_t> _batchSize {};
+    std::atomic<double> _drainRate {};
+    std::atomic<std::uint64_t> _errors {};
+
+    std::atomic<bool> _quit {};
+    // guards _lastError, and wakes the thread to quit
+    mutable std::mutex _mutex {};
+    std::string _lastError {};
+    std::condition_variable _condition {};
+    std::thread _thread {};
+};
+
+inline QueueStreamer::QueueStreamer(AudioDevice& device, Source source, std::uint32_t lowWatermarkMs, std::uint32_t highWatermarkMs, AudioClock* clock)
+    : _device(device),
+      _source(std::move(source)),
+      _clock(clock),
+      _frameSize(device.getObtainedSpec().channels * SDL_AUDIO_BITSIZE(device.getObtainedSpec().format) / 8),
+      _bytesPerSecond(static_cast<std::uint32_t>(device.getObtainedSpec().freq) * _frameSize),
+      _lowBytes(toBytes(lowWatermarkMs)),
+      _highBytes(std::max(toBytes(highWatermarkMs), _lowBytes + _frameSize)),
+      _buffer(new std::uint8_t[_highBytes]),
+      _drainRate(_bytesPerSecond)
+{
+    assert(_source);
+    assert(lowWatermarkMs <= highWatermarkMs);
+
+    _thread = std::thread(&QueueStreamer::run, this);
+}
+
+inline QueueStreamer::~QueueStreamer()
+{
+    {
+        std::lock_guard<std::mutex> lock {_mutex};
+        _quit.store(true);
+    }
+    _condition.notify_one();
+    _thread.join();
+}
+
+inline std::uint32_t QueueStreamer::getLatency() const
+{
+    return _latency.load(std::memory_order_relaxed);
+}
+
+inline std::uint64_t QueueStreamer::getUnderruns() const
+{
+    return _underruns.load(std::memory_order_relaxed);
+}
+
+inline std::uint32_t QueueStreamer::getBatchSize() const
+{
+    return _batchSize.load(std::memory_order_relaxed);
+}
+
+inline double QueueStreamer::getDrainRate() const
+{
+    return _drainRate.load(std::memory_order_relaxed);
+}
+
+inline std::uint64_t QueueStreamer::getErrors() const
+{
+    return _errors.load(std::memory_order_relaxed);
+}
+
+inline std::string QueueStreamer::getLastError() const
+{
+    std::lock_guard<std::mutex> lock {_mutex};
+    return _lastError;
+}
+
+inline void QueueStreamer::run()
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::uint32_t expectedSize = 0;
+    // produced, but not yet queued
+    std::uint32_t pending = 0;
+    Clock::time_point lastPoll = Clock::now();
+    double drainRate = _bytesPerSecond;
+
+    while(!_quit.load()) {
+        std::uint32_t queued = _device.getQueueSize();
+        if(_clock != nullptr) {
+            _clock->update(_device);
+        }
+        Clock::time_point now = Clock::now();
+        _latency.store(static_cast<std::uint32_t>(std::uint64_t{queued} * 1000000 / _bytesPerSecond), std::memory_order_relaxed);
+
+        bool playing = _device.getStatus() == SDL_AUDIO_PLAYING;
+        if(playing) {
+            if(queued == 0 && expectedSize > 0) {
+                _underruns.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            // ignore empty queues, which drain no faster than we fill them
+            double seconds = std::chrono::duration<double>(now - lastPoll).count();
+            if(queued > 0 && expectedSize > queued && seconds > 0.0) {
+                double measured = (expectedSize - queued) / seconds;
+                drainRate += (measured - drainRate) * 0.25;
+                _drainRate.store(drainRate, std::memory_order_relaxed);
+            }
+        }
+        lastPoll = now;
+
+        if(pending == 0 && (queued < _lowBytes || queued == 0)) {
+            std::uint32_t want = (_highBytes - queued) / _frameSize * _frameSize;
+            pending = _source(_buffer.get(), want) / _frameSize * _frameSize;
+            _batchSize.store(pending, std::memory_order_relaxed);
+        }
+        if(pending > 0) {
+            try {
+                _device.queue(_buffer.get(), pending);
+                if(_clock != nullptr) {
+                    _clock->addQueued(pending);
+                }
+                queued += pending;
+                pending = 0;
+            }
+            catch(const SdlError& error) {
+                // an exception leaving this thread would terminate the process
+                _errors.fetch_add(1, std::memory_order_relaxed);
+                std::lock_guard<std::mutex> lock {_mutex};
+                _lastError = error.what();
+            }
+        }
+        expectedSize = queued;
+
+        // sleep until the queue should reach the low watermark, but at least 1 ms
+        std::chrono::microseconds sleep {1000};
+        if(playing && queued > _lowBytes) {
+            sleep = std::max(sleep, std::chrono::microseconds(static_cast<std::int64_t>((queued - _lowBytes) * 1e6 / drainRate)));
+        }
+        std::unique_lock<std::mutex> lock {_mutex};
+        _condition.wait_for(lock, sleep, [&] { return _quit.load(); });
+    }
+}
+
+inline std::uint32_t QueueStreamer::toBytes(std::uint32_t milliseconds) const
+{
+    std::uint32_t bytes = static_cast<std::uint32_t>(std::uint64_t{_bytesPerSecond} * milliseconds / 1000);
+    return bytes / _frameSize * _frameSize;
+}
+
+} // namespace sdlwrapper
+
+#endif // SDLWRAPPER_AUDIO_SUPPORTS_NONCALLBACK
+
+#endif // SDLWRAPPER_QUEUE_STREAMER_HPP
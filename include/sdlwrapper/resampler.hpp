@@ -0,0 +1,282 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef SDLWRAPPER_RESAMPLER_HPP
+#define SDLWRAPPER_RESAMPLER_HPP
+
+#include "sdlwrapper/detail/simd.hpp"
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace sdlwrapper
+{
+
+enum class ResamplerQuality
+{
+    // 2 taps, cheapest, audible aliasing
+    LINEAR,
+    // 16 tap windowed sinc
+    SINC_MEDIUM,
+    // 32 tap windowed sinc
+    SINC_HIGH
+};
+
+namespace detail
+{
+
+inline float dotProduct(const float* a, const float* b, std::size_t n)
+{
+    std::size_t i = 0;
+    Float4 sum4 = Float4::splat(0.0f);
+    for(; i + Float4::SIZE <= n; i += Float4::SIZE) {
+        sum4 = sum4 + Float4::load(a + i) * Float4::load(b + i);
+    }
+    float lanes[Float4::SIZE];
+    sum4.store(lanes);
+    float sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for(; i < n; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+// out = a + (b - a) * t
+inline void lerp(float* out, const float* a, const float* b, float t, std::size_t n)
+{
+    std::size_t i = 0;
+    Float4 t4 = Float4::splat(t);
+    for(; i + Float4::SIZE <= n; i += Float4::SIZE) {
+        Float4 a4 = Float4::load(a + i);
+        (a4 + (Float4::load(b + i) - a4) * t4).store(out + i);
+    }
+    for(; i < n; ++i) {
+        out[i] = a[i] + (b[i] - a[i]) * t;
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Streaming sample rate converter for interleaved float frames.
+ *
+ * All state is allocated up front, so one Resampler per voice can run inside the audio callback.
+ * Sinc qualities use a polyphase table, linearly interpolated between phases.
+ * Output is aligned with the input, so the final getLatency() input frames
+ * are only produced once more input, or silence, follows them.
+ */
+class Resampler
+{
+public:
+    struct Result
+    {
+        std::size_t inputFrames;
+        std::size_t outputFrames;
+    };
+
+    Resampler(int srcFreq, int dstFreq, std::uint8_t channels, ResamplerQuality quality = ResamplerQuality::SINC_MEDIUM);
+
+    /**
+     * @brief Resample until the input is consumed or the output is full.
+     * @param in  Interleaved source frames
+     * @param inFrames  Number of source frames
+     * @param out  Interleaved destination frames
+     * @param outFrames  Capacity of destination in frames
+     * @return Number of frames consumed and produced
+     */
+    Result process(const float* in, std::size_t inFrames, float* out, std::size_t outFrames);
+
+    /**
+     * @brief Forget all input, as if newly constructed.
+     */
+    void reset();
+
+    /**
+     * @brief Get the largest number of frames produced from inFrames of input.
+     */
+    std::size_t getMaxOutputFrames(std::size_t inFrames) const;
+
+    /**
+     * @brief Get the number of input frames held back for the filter.
+     */
+    int getLatency() const;
+
+    int getSrcFreq() const;
+
+    int getDstFreq() const;
+
+    std::uint8_t getChannels() const;
+
+private:
+    static constexpr std::uint64_t ONE = std::uint64_t{1} << 32;
+    static constexpr int PHASES = 256;
+
+    void push(const float* frame);
+    const float* getCoefficients(std::uint32_t fraction);
+
+    int _srcFreq;
+    int _dstFreq;
+    std::uint8_t _channels;
+    std::size_t _taps;
+
+    // 32.32 fixed point input frames per output frame
+    std::uint64_t _step;
+    // 32.32 fixed point input position, relative to the center of the window
+    std::uint64_t _position {};
+
+    // (PHASES + 1) rows of _taps coefficients, empty for linear
+    std::vector<float> _table;
+    std::vector<float> _coefficients;
+
+    // per channel, the window is stored twice so it is always contiguous
+    std::vector<float> _history;
+    std::size_t _historyIndex {};
+};
+
+inline Resampler::Resampler(int srcFreq, int dstFreq, std::uint8_t channels, ResamplerQuality quality)
+    : _srcFreq(srcFreq),
+      _dstFreq(dstFreq),
+      _channels(channels),
+      _taps(quality == ResamplerQuality::LINEAR ? 2 : quality == ResamplerQuality::SINC_MEDIUM ? 16 : 32),
+      _step((static_cast<std::uint64_t>(srcFreq) << 32) / static_cast<std::uint64_t>(dstFreq)),
+      _coefficients(_taps),
+      _history(channels * _taps * 2)
+{
+    assert(srcFreq > 0 && dstFreq > 0 && channels > 0);
+
+    if(quality != ResamplerQuality::LINEAR) {
+        // lower the cutoff when downsampling, to filter out frequencies the destination can't hold
+        double rolloff = quality == ResamplerQuality::SINC_MEDIUM ? 0.9 : 0.95;
+        double cutoff = std::min(1.0, static_cast<double>(dstFreq) / srcFreq) * rolloff;
+        double halfWidth = static_cast<double>(_taps) / 2.0;
+
+        _table.resize((PHASES + 1) * _taps);
+        for(int phase = 0; phase <= PHASES; ++phase) {
+            float* row = _table.data() + phase * _taps;
+            double sum = 0.0;
+            for(std::size_t tap = 0; tap < _taps; ++tap) {
+                double x = static_cast<double>(tap) - (halfWidth - 1.0) - static_cast<double>(phase) / PHASES;
+                double sinc = x == 0.0 ? 1.0 : std::sin(M_PI * cutoff * x) / (M_PI * cutoff * x);
+                double t = x / halfWidth;
+                double blackman = std::abs(t) >= 1.0 ? 0.0 : 0.42 + 0.5 * std::cos(M_PI * t) + 0.08 * std::cos(2.0 * M_PI * t);
+                double value = sinc * blackman;
+                row[tap] = static_cast<float>(value);
+                sum += value;
+            }
+            // unity gain at DC for every phase
+            for(std::size_t tap = 0; tap < _taps; ++tap) {
+                row[tap] = static_cast<float>(row[tap] / sum);
+            }
+        }
+    }
+
+    reset();
+}
+
+inline Resampler::Result Resampler::process(const float* in, std::size_t inFrames, float* out, std::size_t outFrames)
+{
+    Result result {0, 0};
+    while(result.outputFrames < outFrames) {
+        while(_position >= ONE) {
+            if(result.inputFrames == inFrames) {
+                return result;
+            }
+            push(in + result.inputFrames * _channels);
+            ++result.inputFrames;
+            _position -= ONE;
+        }
+
+        const float* coefficients = getCoefficients(static_cast<std::uint32_t>(_position));
+        for(std::uint8_t channel = 0; channel < _channels; ++channel) {
+            const float* window = _history.data() + channel * _taps * 2 + _historyIndex;
+            out[result.outputFrames * _channels + channel] = detail::dotProduct(window, coefficients, _taps);
+        }
+
+        ++result.outputFrames;
+        _position += _step;
+    }
+    return result;
+}
+
+inline void Resampler::reset()
+{
+    std::fill(_history.begin(), _history.end(), 0.0f);
+    _historyIndex = 0;
+    // consume enough input that the first output lands on the first input frame
+    _position = (_taps / 2 + 1) * ONE;
+}
+
+inline std::size_t Resampler::getMaxOutputFrames(std::size_t inFrames) const
+{
+    return static_cast<std::size_t>((static_cast<std::uint64_t>(inFrames) * _dstFreq + _srcFreq - 1) / _srcFreq) + 1;
+}
+
+inline int Resampler::getLatency() const
+{
+    return static_cast<int>(_taps / 2);
+}
+
+inline int Resampler::getSrcFreq() const
+{
+    return _srcFreq;
+}
+
+inline int Resampler::getDstFreq() const
+{
+    return _dstFreq;
+}
+
+inline std::uint8_t Resampler::getChannels() const
+{
+    return _channels;
+}
+
+inline void Resampler::push(const float* frame)
+{
+    for(std::uint8_t channel = 0; channel < _channels; ++channel) {
+        float* history = _history.data() + channel * _taps * 2;
+        history[_historyIndex] = frame[channel];
+        history[_historyIndex + _taps] = frame[channel];
+    }
+    _historyIndex = (_historyIndex + 1) % _taps;
+}
+
+inline const float* Resampler::getCoefficients(std::uint32_t fraction)
+{
+    if(_table.empty()) {
+        float t = static_cast<float>(fraction) * (1.0f / 4294967296.0f);
+        _coefficients[0] = 1.0f - t;
+        _coefficients[1] = t;
+    }
+    else {
+        // top bits select the phase, the rest interpolate to the next phase
+        constexpr int phaseBits = 8;
+        static_assert(PHASES == 1 << phaseBits, "PHASES must match phaseBits");
+        std::uint32_t phase = fraction >> (32 - phaseBits);
+        float t = static_cast<float>(fraction & ((1u << (32 - phaseBits)) - 1)) * (1.0f / (1u << (32 - phaseBits)));
+        const float* row = _table.data() + phase * _taps;
+        detail::lerp(_coefficients.data(), row, row + _taps, t, _taps);
+    }
+    return _coefficients.data();
+}
+
+} // namespace sdlwrapper
+
+#endif // SDLWRAPPER_RESAMPLER_HPP
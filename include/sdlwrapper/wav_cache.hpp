@@ -0,0 +1,333 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef SDLWRAPPER_WAV_CACHE_HPP
+#define SDLWRAPPER_WAV_CACHE_HPP
+
+#include "sdlwrapper/audio.hpp"
+#include "sdlwrapper/sdl_error.hpp"
+
+#include <SDL.h>
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace sdlwrapper
+{
+
+/**
+ * @brief Immutable samples, already converted to a device's format.
+ */
+class AudioAsset
+{
+public:
+    AudioAsset(std::vector<std::uint8_t> data, int freq, AudioFormat format, std::uint8_t channels);
+
+    std::uint32_t getSizeBytes() const;
+
+    int getFreq() const;
+
+    AudioFormat getAudioFormat() const;
+
+    std::uint8_t getChannels() const;
+
+    const std::uint8_t* begin() const;
+
+    const std::uint8_t* end() const;
+
+private:
+    std::vector<std::uint8_t> _data;
+    int _freq;
+    AudioFormat _format;
+    std::uint8_t _channels;
+};
+
+/**
+ * @brief Load a WAV file into an AudioAsset, converted to the spec's freq, format and channels.
+ * @param spec  Target spec, or nullptr to keep the file's own
+ * @throws SdlError
+ */
+std::shared_ptr<const AudioAsset> loadAudioAsset(const AudioSubsystem&, const char* fileName, const SDL_AudioSpec* spec = nullptr);
+
+/**
+ * @brief Loads each WAV file once per target spec, and shares the converted samples.
+ *
+ * Assets are kept until the total size of cached samples exceeds the budget,
+ * then the least recently used are evicted. An evicted asset stays alive
+ * until its last handle is destroyed, so the budget does not bound handles held elsewhere.
+ *
+ * Every function may be called from any thread.
+ */
+class WavCache
+{
+public:
+    using Handle = std::shared_ptr<const AudioAsset>;
+
+    struct Stats
+    {
+        std::uint64_t hits;
+        std::uint64_t misses;
+        std::uint64_t evictions;
+        std::size_t entries;
+        std::size_t sizeBytes;
+    };
+
+    /**
+     * @param budgetBytes  Total size of converted samples to keep cached
+     */
+    WavCache(const AudioSubsystem&, std::size_t budgetBytes);
+
+    WavCache(const WavCache&) = delete;
+    WavCache& operator=(const WavCache&) = delete;
+
+    /**
+     * @brief Get a WAV file converted to the spec's freq, format and channels, loading it on a miss.
+     *
+     * Files are loaded and converted without holding the cache lock,
+     * so two threads missing on the same key at once both load it, and the first to finish is kept.
+     *
+     * @param spec  Target spec, usually AudioDevice::getObtainedSpec()
+     * @throws SdlError
+     */
+    Handle load(const char* fileName, const SDL_AudioSpec& spec);
+
+    /**
+     * @brief Evict every asset.
+     */
+    void clear();
+
+    /**
+     * @brief Change the budget, evicting assets until the cache fits.
+     */
+    void setBudget(std::size_t budgetBytes);
+
+    std::size_t getBudget() const;
+
+    Stats getStats() const;
+
+private:
+    struct Key
+    {
+        std::string fileName;
+        int freq;
+        AudioFormat format;
+        std::uint8_t channels;
+
+        bool operator==(const Key& other) const;
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(const Key& key) const;
+    };
+
+    struct Entry
+    {
+        Key key;
+        Handle asset;
+    };
+
+    // requires _mutex
+    void evict();
+
+    AudioSubsystem _subsystem;
+    std::size_t _budget;
+
+    mutable std::mutex _mutex {};
+    // most recently used first
+    std::list<Entry> _entries {};
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> _index {};
+    std::size_t _sizeBytes {};
+    Stats _stats {};
+};
+
+inline AudioAsset::AudioAsset(std::vector<std::uint8_t> data, int freq, AudioFormat format, std::uint8_t channels)
+    : _data(std::move(data)),
+      _freq(freq),
+      _format(format),
+      _channels(channels)
+{
+}
+
+inline std::uint32_t AudioAsset::getSizeBytes() const
+{
+    return static_cast<std::uint32_t>(_data.size());
+}
+
+inline int AudioAsset::getFreq() const
+{
+    return _freq;
+}
+
+inline AudioFormat AudioAsset::getAudioFormat() const
+{
+    return _format;
+}
+
+inline std::uint8_t AudioAsset::getChannels() const
+{
+    return _channels;
+}
+
+inline const std::uint8_t* AudioAsset::begin() const
+{
+    return _data.data();
+}
+
+inline const std::uint8_t* AudioAsset::end() const
+{
+    return _data.data() + _data.size();
+}
+
+inline std::shared_ptr<const AudioAsset> loadAudioAsset(const AudioSubsystem& subsystem, const char* fileName, const SDL_AudioSpec* spec)
+{
+    Wav wav {subsystem, fileName};
+    int freq = spec != nullptr ? spec->freq : wav.getFreq();
+    AudioFormat format = spec != nullptr ? spec->format : wav.getAudioFormat();
+    std::uint8_t channels = spec != nullptr ? spec->channels : wav.getChannels();
+
+    SDL_AudioCVT cvt;
+    int built = SDL_BuildAudioCVT(&cvt, wav.getAudioFormat(), wav.getChannels(), wav.getFreq(), format, channels, freq);
+    if(built < 0) {
+        throw SdlError{};
+    }
+
+    std::vector<std::uint8_t> data;
+    if(built == 0) {
+        data.assign(wav.begin(), wav.end());
+    }
+    else {
+        // SDL converts in place, in a buffer len_mult times the source length
+        data.resize(static_cast<std::size_t>(wav.getSizeBytes()) * cvt.len_mult);
+        std::memcpy(data.data(), wav.begin(), wav.getSizeBytes());
+        cvt.buf = data.data();
+        cvt.len = static_cast<int>(wav.getSizeBytes());
+        if(SDL_ConvertAudio(&cvt) < 0) {
+            throw SdlError{};
+        }
+        data.resize(static_cast<std::size_t>(cvt.len_cvt));
+        data.shrink_to_fit();
+    }
+
+    return std::make_shared<const AudioAsset>(std::move(data), freq, format, channels);
+}
+
+inline bool WavCache::Key::operator==(const Key& other) const
+{
+    return fileName == other.fileName && freq == other.freq && format == other.format && channels == other.channels;
+}
+
+inline std::size_t WavCache::KeyHash::operator()(const Key& key) const
+{
+    std::size_t hash = std::hash<std::string>{}(key.fileName);
+    std::size_t spec = (static_cast<std::size_t>(key.freq) * 31 + key.format) * 31 + key.channels;
+    return hash ^ (spec + 0x9e3779b9 + (hash << 6) + (hash >> 2));
+}
+
+inline WavCache::WavCache(const AudioSubsystem& subsystem, std::size_t budgetBytes)
+    : _subsystem(subsystem),
+      _budget(budgetBytes)
+{
+}
+
+inline WavCache::Handle WavCache::load(const char* fileName, const SDL_AudioSpec& spec)
+{
+    checkAudioRt(AudioRtViolation::LOCK, "WavCache::load");
+
+    Key key {fileName, spec.freq, spec.format, spec.channels};
+
+    {
+        std::lock_guard<std::mutex> lock {_mutex};
+        auto found = _index.find(key);
+        if(found != _index.end()) {
+            ++_stats.hits;
+            _entries.splice(_entries.begin(), _entries, found->second);
+            return found->second->asset;
+        }
+        ++_stats.misses;
+    }
+
+    Handle asset = loadAudioAsset(_subsystem, fileName, &spec);
+
+    std::lock_guard<std::mutex> lock {_mutex};
+    auto found = _index.find(key);
+    if(found != _index.end()) {
+        // another thread loaded it first
+        _entries.splice(_entries.begin(), _entries, found->second);
+        return found->second->asset;
+    }
+    _entries.push_front(Entry{key, asset});
+    _index.emplace(std::move(key), _entries.begin());
+    _sizeBytes += asset->getSizeBytes();
+    evict();
+    return asset;
+}
+
+inline void WavCache::clear()
+{
+    checkAudioRt(AudioRtViolation::LOCK, "WavCache::clear");
+    std::lock_guard<std::mutex> lock {_mutex};
+    _stats.evictions += _entries.size();
+    _entries.clear();
+    _index.clear();
+    _sizeBytes = 0;
+}
+
+inline void WavCache::setBudget(std::size_t budgetBytes)
+{
+    checkAudioRt(AudioRtViolation::LOCK, "WavCache::setBudget");
+    std::lock_guard<std::mutex> lock {_mutex};
+    _budget = budgetBytes;
+    evict();
+}
+
+inline std::size_t WavCache::getBudget() const
+{
+    checkAudioRt(AudioRtViolation::LOCK, "WavCache::getBudget");
+    std::lock_guard<std::mutex> lock {_mutex};
+    return _budget;
+}
+
+inline WavCache::Stats WavCache::getStats() const
+{
+    checkAudioRt(AudioRtViolation::LOCK, "WavCache::getStats");
+    std::lock_guard<std::mutex> lock {_mutex};
+    Stats stats = _stats;
+    stats.entries = _entries.size();
+    stats.sizeBytes = _sizeBytes;
+    return stats;
+}
+
+inline void WavCache::evict()
+{
+    while(_sizeBytes > _budget) {
+        Entry& oldest = _entries.back();
+        _sizeBytes -= oldest.asset->getSizeBytes();
+        _index.erase(oldest.key);
+        _entries.pop_back();
+        ++_stats.evictions;
+    }
+}
+
+} // namespace sdlwrapper
+
+#endif // SDLWRAPPER_WAV_CACHE_HPP
@@ -0,0 +1,235 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef SDLWRAPPER_WAV_LOADER_HPP
+#define SDLWRAPPER_WAV_LOADER_HPP
+
+#include "sdlwrapper/audio.hpp"
+#include "sdlwrapper/sdl_error.hpp"
+#include "sdlwrapper/wav_cache.hpp"
+#include "sdlwrapper/detail/thread_pool.hpp"
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace sdlwrapper
+{
+
+/**
+ * @brief Futures for a batch of files loading on a WavLoader.
+ */
+struct WavBatch
+{
+    // in the order the files were given, get() rethrows SdlError if a file failed
+    std::vector<std::future<std::shared_ptr<const AudioAsset>>> assets;
+    // ready once every file has finished, holding the time since the batch was submitted
+    std::future<std::chrono::microseconds> wallTime;
+};
+
+/**
+ * @brief A finished batch of files, passed to a WavLoader::Completion.
+ */
+struct WavBatchResult
+{
+    // in the order the files were given, null if a file failed
+    std::vector<std::shared_ptr<const AudioAsset>> assets;
+    // error message for each failed file, empty for loaded files
+    std::vector<std::string> errors;
+    // time from submitting the batch until the last file finished
+    std::chrono::microseconds wallTime;
+};
+
+/**
+ * @brief Loads, parses and converts batches of WAV files on a pool of worker threads.
+ *
+ * Files in a batch start largest first, so one long file does not finish alone after the rest.
+ * Destroying the loader waits for every submitted file.
+ */
+class WavLoader
+{
+public:
+    /**
+     * @brief Called once per batch, on the worker which finished the last file.
+     */
+    using Completion = std::function<void(WavBatchResult result)>;
+
+    /**
+     * @param threads  Number of worker threads, or 0 for one per core
+     */
+    explicit WavLoader(const AudioSubsystem&, std::size_t threads = 0);
+
+    WavLoader(const WavLoader&) = delete;
+    WavLoader& operator=(const WavLoader&) = delete;
+
+    /**
+     * @brief Start loading a batch of files.
+     * @param spec  Convert every file to this spec, or nullptr to keep each file's own
+     */
+    WavBatch load(const std::vector<std::string>& fileNames, const SDL_AudioSpec* spec = nullptr);
+
+    /**
+     * @brief Start loading a batch of files, and call done when all have finished.
+     *
+     * An empty batch calls done immediately, on the calling thread.
+     *
+     * @param spec  Convert every file to this spec, or nullptr to keep each file's own
+     */
+    void load(const std::vector<std::string>& fileNames, const SDL_AudioSpec* spec, Completion done);
+
+    std::size_t getThreads() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // indices of fileNames, largest file first
+    static std::vector<std::size_t> orderBySize(const std::vector<std::string>& fileNames);
+
+    static std::chrono::microseconds getElapsed(Clock::time_point start);
+
+    AudioSubsystem _subsystem;
+    detail::ThreadPool _pool;
+};
+
+inline WavLoader::WavLoader(const AudioSubsystem& subsystem, std::size_t threads)
+    : _subsystem(subsystem),
+      _pool(threads)
+{
+}
+
+inline WavBatch WavLoader::load(const std::vector<std::string>& fileNames, const SDL_AudioSpec* spec)
+{
+    struct State
+    {
+        Clock::time_point start;
+        std::atomic<std::size_t> remaining;
+        std::promise<std::chrono::microseconds> wallTime;
+    };
+
+    std::shared_ptr<State> state = std::make_shared<State>();
+    state->start = Clock::now();
+    state->remaining.store(fileNames.size());
+
+    WavBatch batch;
+    batch.assets.resize(fileNames.size());
+    batch.wallTime = state->wallTime.get_future();
+    if(fileNames.empty()) {
+        state->wallTime.set_value(std::chrono::microseconds{0});
+        return batch;
+    }
+
+    std::shared_ptr<const SDL_AudioSpec> target = spec != nullptr ? std::make_shared<const SDL_AudioSpec>(*spec) : nullptr;
+    for(std::size_t i : orderBySize(fileNames)) {
+        batch.assets[i] = _pool.submit([this, state, target, fileName = fileNames[i]] {
+            // count the file as finished however it leaves
+            struct Finish
+            {
+                State& state;
+                ~Finish()
+                {
+                    if(state.remaining.fetch_sub(1) == 1) {
+                        state.wallTime.set_value(getElapsed(state.start));
+                    }
+                }
+            } finish {*state};
+            return loadAudioAsset(_subsystem, fileName.c_str(), target.get());
+        });
+    }
+    return batch;
+}
+
+inline void WavLoader::load(const std::vector<std::string>& fileNames, const SDL_AudioSpec* spec, Completion done)
+{
+    struct State
+    {
+        Clock::time_point start;
+        std::atomic<std::size_t> remaining;
+        WavBatchResult result;
+        Completion done;
+    };
+
+    std::shared_ptr<State> state = std::make_shared<State>();
+    state->start = Clock::now();
+    state->remaining.store(fileNames.size());
+    state->result.assets.resize(fileNames.size());
+    state->result.errors.resize(fileNames.size());
+    state->done = std::move(done);
+    if(fileNames.empty()) {
+        state->result.wallTime = std::chrono::microseconds{0};
+        state->done(std::move(state->result));
+        return;
+    }
+
+    std::shared_ptr<const SDL_AudioSpec> target = spec != nullptr ? std::make_shared<const SDL_AudioSpec>(*spec) : nullptr;
+    for(std::size_t i : orderBySize(fileNames)) {
+        _pool.submit([this, state, target, i, fileName = fileNames[i]] {
+            // each worker writes only its own index
+            try {
+                state->result.assets[i] = loadAudioAsset(_subsystem, fileName.c_str(), target.get());
+            }
+            catch(const std::exception& e) {
+                state->result.errors[i] = e.what();
+            }
+
+            if(state->remaining.fetch_sub(1) == 1) {
+                state->result.wallTime = getElapsed(state->start);
+                state->done(std::move(state->result));
+            }
+        });
+    }
+}
+
+inline std::size_t WavLoader::getThreads() const
+{
+    return _pool.getThreads();
+}
+
+inline std::vector<std::size_t> WavLoader::orderBySize(const std::vector<std::string>& fileNames)
+{
+    // files which can't be opened sort last, and fail on a worker
+    std::vector<Sint64> sizes(fileNames.size(), -1);
+    for(std::size_t i = 0; i < fileNames.size(); ++i) {
+        if(SDL_RWops* rw = SDL_RWFromFile(fileNames[i].c_str(), "rb")) {
+            sizes[i] = SDL_RWsize(rw);
+            SDL_RWclose(rw);
+        }
+    }
+
+    std::vector<std::size_t> order(fileNames.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return sizes[a] > sizes[b];
+    });
+    return order;
+}
+
+inline std::chrono::microseconds WavLoader::getElapsed(Clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start);
+}
+
+} // namespace sdlwrapper
+
+#endif // SDLWRAPPER_WAV_LOADER_HPP
@@ -0,0 +1,294 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef SDLWRAPPER_WAV_STREAM_HPP
+#define SDLWRAPPER_WAV_STREAM_HPP
+
+#include "sdlwrapper/audio.hpp"
+#include "sdlwrapper/sdl_error.hpp"
+#include "sdlwrapper/detail/wav_header.hpp"
+
+#include <cwrapper/resource.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace sdlwrapper
+{
+
+/**
+ * @brief Plays a WAV file without loading it into memory.
+ *
+ * The RIFF header is parsed once, then a background thread reads the PCM data
+ * into two fixed-size chunks, while the audio thread drains the other.
+ * Resident memory is two chunks, regardless of the file length.
+ *
+ * One consumer thread may call read, queue or callback.
+ */
+class WavStream
+{
+public:
+    static constexpr std::uint32_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+    /**
+     * @param fileName  Uncompressed PCM or float WAV file
+     * @param loop  Restart from the first sample at the end of the file
+     * @param chunkSizeBytes  Size of each of the two read buffers
+     * @throws SdlError
+     */
+    WavStream(const AudioSubsystem&, const char* fileName, bool loop = false, std::uint32_t chunkSizeBytes = DEFAULT_CHUNK_SIZE);
+
+    WavStream(const WavStream&) = delete;
+    WavStream& operator=(const WavStream&) = delete;
+
+    ~WavStream();
+
+    /**
+     * @brief Get the size of the PCM data in the file.
+     */
+    std::uint32_t getSizeBytes() const;
+
+    int getFreq() const;
+
+    AudioFormat getAudioFormat() const;
+
+    std::uint8_t getChannels() const;
+
+    /**
+     * @brief Copy up to len bytes of samples. Never blocks.
+     * @return Number of bytes copied, less than len if the reader thread fell behind or the file ended
+     */
+    std::uint32_t read(std::uint8_t* data, std::uint32_t len);
+
+#ifdef SDLWRAPPER_AUDIO_SUPPORTS_NONCALLBACK
+    /**
+     * @brief Queue up to len bytes of samples on a non-callback output device, straight from the read buffers. Never blocks.
+     * @return Number of bytes queued
+     */
+    std::uint32_t queue(AudioDevice& device, std::uint32_t len);
+#endif // SDLWRAPPER_AUDIO_SUPPORTS_NONCALLBACK
+
+    /**
+     * @brief Check if every sample has been consumed. Never true when looping.
+     */
+    bool isFinished() const;
+
+    /**
+     * @brief Get the number of callbacks which played silence because the reader thread fell behind.
+     */
+    std::uint64_t getUnderruns() const;
+
+    /**
+     * @brief SDL_AudioCallback for an AudioDevice matching the stream's format, pass the WavStream as userdata.
+     */
+    static void callback(void* userdata, std::uint8_t* stream, int len);
+
+private:
+    struct Chunk
+    {
+        std::unique_ptr<std::uint8_t[]> data;
+        std::uint32_t size {};
+        std::atomic<bool> full {};
+    };
+
+    template <typename Sink>
+    std::uint32_t consume(std::uint32_t len, Sink sink);
+
+    void run();
+
+    cwrapper::Resource<SDL_RWops*, detail::RWopsDeleter> _resource {};
+    detail::WavHeader _header {};
+    bool _loop {};
+    std::uint32_t _chunkSize {};
+
+    std::array<Chunk, 2> _chunks {};
+
+    // consumer state
+    std::size_t _readChunk {};
+    std::uint32_t _readOffset {};
+    std::atomic<std::uint64_t> _underruns {};
+
+    // reader thread state
+    std::atomic<bool> _endOfFile {};
+    std::atomic<bool> _quit {};
+    std::mutex _mutex {};
+    std::condition_variable _condition {};
+    std::thread _thread {};
+};
+
+inline WavStream::WavStream(const AudioSubsystem&, const char* fileName, bool loop, std::uint32_t chunkSizeBytes)
+    : _resource(SDL_RWFromFile(fileName, "rb")),
+      _loop(loop),
+      _chunkSize(chunkSizeBytes)
+{
+    assert(chunkSizeBytes > 0);
+
+    if(!_resource.hasHandle()) {
+        throw SdlError{};
+    }
+    _header = detail::readWavHeader(_resource.getHandle());
+
+    for(Chunk& chunk : _chunks) {
+        chunk.data.reset(new std::uint8_t[_chunkSize]);
+    }
+
+    _thread = std::thread(&WavStream::run, this);
+}
+
+inline WavStream::~WavStream()
+{
+    _quit.store(true);
+    _condition.notify_one();
+    _thread.join();
+}
+
+inline std::uint32_t WavStream::getSizeBytes() const
+{
+    return _header.dataSize;
+}
+
+inline int WavStream::getFreq() const
+{
+    return _header.freq;
+}
+
+inline AudioFormat WavStream::getAudioFormat() const
+{
+    return _header.format;
+}
+
+inline std::uint8_t WavStream::getChannels() const
+{
+    return _header.channels;
+}
+
+inline std::uint32_t WavStream::read(std::uint8_t* data, std::uint32_t len)
+{
+    return consume(len, [&](const std::uint8_t* chunkData, std::uint32_t n) {
+        std::memcpy(data, chunkData, n);
+        data += n;
+    });
+}
+
+#ifdef SDLWRAPPER_AUDIO_SUPPORTS_NONCALLBACK
+inline std::uint32_t WavStream::queue(AudioDevice& device, std::uint32_t len)
+{
+    return consume(len, [&](const std::uint8_t* chunkData, std::uint32_t n) {
+        device.queue(chunkData, n);
+    });
+}
+#endif // SDLWRAPPER_AUDIO_SUPPORTS_NONCALLBACK
+
+inline bool WavStream::isFinished() const
+{
+    // chunks fill and drain in the same order,
+    // so once the next chunk is empty, every filled chunk has been consumed
+    return _endOfFile.load(std::memory_order_acquire) && !_chunks[_readChunk].full.load(std::memory_order_acquire);
+}
+
+inline std::uint64_t WavStream::getUnderruns() const
+{
+    return _underruns.load(std::memory_order_relaxed);
+}
+
+inline void WavStream::callback(void* userdata, std::uint8_t* stream, int len)
+{
+    WavStream* wavStream = reinterpret_cast<WavStream*>(userdata);
+    std::uint32_t numRead = wavStream->read(stream, static_cast<std::uint32_t>(len));
+    if(numRead < static_cast<std::uint32_t>(len)) {
+        if(!wavStream->isFinished()) {
+            wavStream->_underruns.fetch_add(1, std::memory_order_relaxed);
+        }
+        std::uint8_t silence = wavStream->_header.format == AUDIO_U8 ? 0x80 : 0x00;
+        std::memset(stream + numRead, silence, len - numRead);
+    }
+}
+
+template <typename Sink>
+std::uint32_t WavStream::consume(std::uint32_t len, Sink sink)
+{
+    std::uint32_t total = 0;
+    while(total < len) {
+        Chunk& chunk = _chunks[_readChunk];
+        if(!chunk.full.load(std::memory_order_acquire)) {
+            break;
+        }
+
+        std::uint32_t n = std::min(len - total, chunk.size - _readOffset);
+        sink(chunk.data.get() + _readOffset, n);
+        total += n;
+        _readOffset += n;
+
+        if(_readOffset == chunk.size) {
+            _readOffset = 0;
+            _readChunk ^= 1;
+            chunk.full.store(false, std::memory_order_release);
+            _condition.notify_one();
+        }
+    }
+    return total;
+}
+
+inline void WavStream::run()
+{
+    SDL_RWops* rw = _resource.getHandle();
+    std::uint32_t remaining = _header.dataSize;
+    std::size_t writeChunk = 0;
+
+    while(!_quit.load()) {
+        Chunk& chunk = _chunks[writeChunk];
+        if(chunk.full.load(std::memory_order_acquire)) {
+            // the consumer notifies without the mutex, so a wakeup can be missed, the timeout bounds the delay
+            std::unique_lock<std::mutex> lock {_mutex};
+            _condition.wait_for(lock, std::chrono::milliseconds(5), [&] {
+                return _quit.load() || !chunk.full.load(std::memory_order_acquire);
+            });
+            continue;
+        }
+
+        if(remaining == 0) {
+            if(!_loop || _header.dataSize == 0 || SDL_RWseek(rw, _header.dataOffset, RW_SEEK_SET) < 0) {
+                break;
+            }
+            remaining = _header.dataSize;
+        }
+
+        std::uint32_t numRead = static_cast<std::uint32_t>(SDL_RWread(rw, chunk.data.get(), 1, std::min(_chunkSize, remaining)));
+        if(numRead == 0) {
+            // read error, treat as the end of the data
+            remaining = 0;
+            _loop = false;
+            continue;
+        }
+        remaining -= numRead;
+
+        chunk.size = numRead;
+        chunk.full.store(true, std::memory_order_release);
+        writeChunk ^= 1;
+    }
+
+    _endOfFile.store(true, std::memory_order_release);
+}
+
+} // namespace sdlwrapper
+
+#endif // SDLWRAPPER_WAV_STREAM_HPP
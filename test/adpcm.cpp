@@ -0,0 +1,89 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "gtest/gtest.h"
+
+#include "sdlwrapper/adpcm.hpp"
+
+#include <cmath>
+#include <vector>
+
+using sdlwrapper::AdpcmReader;
+using sdlwrapper::AdpcmSamples;
+using sdlwrapper::Sdl;
+using sdlwrapper::SubsystemType;
+using sdlwrapper::Wav;
+
+TEST(Adpcm, RoundTrip) {
+    // stereo tones, long enough for a partial last block
+    const std::uint32_t frameCount = 3000;
+    std::vector<std::int16_t> frames(frameCount * 2);
+    for(std::uint32_t i = 0; i < frameCount; ++i) {
+        frames[i * 2] = static_cast<std::int16_t>(16000 * std::sin(i * 0.02));
+        frames[i * 2 + 1] = static_cast<std::int16_t>(8000 * std::sin(i * 0.11));
+    }
+
+    AdpcmSamples samples {frames.data(), frameCount, 48000, 2};
+    EXPECT_EQ(samples.getFrameCount(), frameCount);
+    EXPECT_EQ(samples.getNumBlocks(), 6u);
+    EXPECT_EQ(samples.getSourceSizeBytes(), frameCount * 2 * sizeof(std::int16_t));
+    EXPECT_LT(samples.getSizeBytes() * 3, samples.getSourceSizeBytes());
+    EXPECT_EQ(samples.getSavedBytes(), samples.getSourceSizeBytes() - samples.getSizeBytes());
+
+    std::vector<float> decoded(frameCount * 2);
+    AdpcmReader reader {samples};
+    EXPECT_EQ(reader.read(decoded.data(), frameCount + 100), frameCount);
+    EXPECT_EQ(reader.read(decoded.data(), 1), 0u);
+
+    double error = 0.0;
+    double signal = 0.0;
+    for(std::size_t i = 0; i < decoded.size(); ++i) {
+        float expected = frames[i] / 32768.0f;
+        error += (decoded[i] - expected) * (decoded[i] - expected);
+        signal += expected * expected;
+    }
+    // better than 30 dB signal to noise
+    EXPECT_LT(error, signal * 1e-3);
+
+    // seeking mid block matches reading through
+    std::vector<float> seeked(10 * 2);
+    reader.seek(1234);
+    EXPECT_EQ(reader.read(seeked.data(), 10), 10u);
+    EXPECT_EQ(reader.getPosition(), 1244u);
+    EXPECT_TRUE(std::equal(seeked.begin(), seeked.end(), decoded.begin() + 1234 * 2));
+
+    // looping wraps to the start
+    AdpcmReader looping {samples, true};
+    looping.seek(frameCount - 5);
+    EXPECT_EQ(looping.read(seeked.data(), 10), 10u);
+    EXPECT_EQ(seeked[10], decoded[0]);
+    EXPECT_EQ(looping.getPosition(), 5u);
+}
+
+TEST(Adpcm, Wav) {
+    Sdl<SubsystemType::AUDIO> sdl;
+    Wav wav {sdl.audio(), SDLWRAPPER_TEST_RES_DIR "/para_open-01.wav"};
+
+    // the test file is AUDIO_F32, which compresses 8:1
+    AdpcmSamples samples {wav};
+    EXPECT_EQ(samples.getChannels(), wav.getChannels());
+    EXPECT_EQ(samples.getSourceSizeBytes(), wav.getSizeBytes());
+    EXPECT_LT(samples.getSizeBytes() * 7, samples.getSourceSizeBytes());
+
+    std::vector<std::uint8_t> stream(4096 * sizeof(float) * samples.getChannels());
+    AdpcmReader reader {samples};
+    AdpcmReader::callback(&reader, stream.data(), static_cast<int>(stream.size()));
+    EXPECT_EQ(reader.getPosition(), std::min(4096u, samples.getFrameCount()));
+}
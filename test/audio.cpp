@@ -16,9 +16,14 @@
 #include "gtest/gtest.h"
 
 #include "sdlwrapper/audio.hpp"
+#include "sdlwrapper/audio_instrumentation.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <cstdio>
 #include <cstring>
+#include <limits>
 #include <type_traits>
 
 using sdlwrapper::Sdl;
@@ -26,7 +31,13 @@ using sdlwrapper::SubsystemType;
 using sdlwrapper::AudioFormat;
 using sdlwrapper::AudioFormatTraits;
 using sdlwrapper::Wav;
+using sdlwrapper::WavLoadMode;
 using sdlwrapper::AudioDevice;
+using sdlwrapper::AudioFormatConstant;
+using sdlwrapper::AudioSpan;
+using sdlwrapper::AudioRingBuffer;
+using sdlwrapper::AudioHistogram;
+using sdlwrapper::AudioCallbackStats;
 
 TEST(SdlAudio, AudioFormatTraits) {
     EXPECT_TRUE(AudioFormatTraits<AUDIO_S8>::sampleSigned);
@@ -59,6 +70,45 @@ TEST(SdlAudio, AudioFormatTraits) {
     }
 }
 
+TEST(SdlAudio, AudioFormatTraitsSilence) {
+    EXPECT_EQ(AudioFormatTraits<AUDIO_U8>::silence, 0x80);
+    EXPECT_EQ(AudioFormatTraits<AUDIO_S8>::silence, 0);
+    EXPECT_EQ(AudioFormatTraits<AUDIO_U16SYS>::silence, 0x8000);
+    EXPECT_EQ(AudioFormatTraits<AUDIO_U16SYS ^ SDL_AUDIO_MASK_ENDIAN>::silence, 0x0080);
+    EXPECT_EQ(AudioFormatTraits<AUDIO_F32>::silence, 0.0f);
+}
+
+TEST(SdlAudio, AudioRingBuffer) {
+    AudioRingBuffer<AUDIO_S16SYS> ringBuffer {5};
+    EXPECT_EQ(ringBuffer.getCapacity(), 8u);
+
+    std::int16_t in[8] {1, 2, 3, 4, 5, 6, 7, 8};
+    std::int16_t out[8] {};
+
+    EXPECT_EQ(ringBuffer.write(in, 6), 6u);
+    EXPECT_EQ(ringBuffer.read(out, 4), 4u);
+    EXPECT_EQ(out[3], 4);
+
+    // wraps around the end of the buffer
+    EXPECT_EQ(ringBuffer.write(in, 8), 6u);
+    EXPECT_EQ(ringBuffer.getReadAvailable(), 8u);
+    EXPECT_EQ(ringBuffer.getWriteAvailable(), 0u);
+
+    EXPECT_EQ(ringBuffer.read(out, 8), 8u);
+    EXPECT_EQ(out[0], 5);
+    EXPECT_EQ(out[1], 6);
+    EXPECT_EQ(out[2], 1);
+    EXPECT_EQ(out[7], 6);
+
+    EXPECT_EQ(ringBuffer.getUnderruns(), 0u);
+    ringBuffer.write(in, 2);
+    EXPECT_EQ(ringBuffer.drain(out, 4), 2u);
+    EXPECT_EQ(out[1], 2);
+    EXPECT_EQ(out[2], 0);
+    EXPECT_EQ(out[3], 0);
+    EXPECT_EQ(ringBuffer.getUnderruns(), 1u);
+}
+
 TEST(SdlAudio, LoadWavFloat) {
     Sdl<SubsystemType::AUDIO> sdl;
 
@@ -70,6 +120,67 @@ TEST(SdlAudio, LoadWavFloat) {
 
 }
 
+TEST(SdlAudio, MapWav) {
+    Sdl<SubsystemType::AUDIO> sdl;
+
+    Wav copied { sdl.audio(), SDLWRAPPER_TEST_RES_DIR "/para_open-01.wav", WavLoadMode::COPY };
+    Wav mapped { sdl.audio(), SDLWRAPPER_TEST_RES_DIR "/para_open-01.wav", WavLoadMode::MAP };
+
+    EXPECT_FALSE(copied.isMapped());
+    EXPECT_TRUE(mapped.isMapped());
+    EXPECT_EQ(mapped.getAudioFormat(), AUDIO_F32);
+    EXPECT_EQ(mapped.getChannels(), 2);
+    EXPECT_EQ(mapped.getFreq(), 96000);
+    ASSERT_EQ(mapped.getSizeBytes(), copied.getSizeBytes());
+    EXPECT_TRUE(std::equal(mapped.begin(), mapped.end(), copied.begin()));
+
+    // writes are private to this mapping
+    Wav moved = std::move(mapped);
+    moved.begin()[0] ^= 0xFF;
+    Wav other { sdl.audio(), SDLWRAPPER_TEST_RES_DIR "/para_open-01.wav", WavLoadMode::MAP };
+    EXPECT_EQ(other.begin()[0], copied.begin()[0]);
+}
+
+TEST(SdlAudio, MapWavMisaligned) {
+    Sdl<SubsystemType::AUDIO> sdl;
+
+    // an 18 byte fmt chunk puts the float samples at offset 46
+    const char* fileName = "map_wav_misaligned_test.wav";
+    const float samples[] = {0.25f, -0.5f, 0.75f, -1.0f};
+    SDL_RWops* rw = SDL_RWFromFile(fileName, "wb");
+    ASSERT_NE(rw, nullptr);
+    SDL_RWwrite(rw, "RIFF", 4, 1);
+    SDL_WriteLE32(rw, 4 + 8 + 18 + 8 + sizeof(samples));
+    SDL_RWwrite(rw, "WAVEfmt ", 8, 1);
+    SDL_WriteLE32(rw, 18);
+    SDL_WriteLE16(rw, 3);
+    SDL_WriteLE16(rw, 1);
+    SDL_WriteLE32(rw, 48000);
+    SDL_WriteLE32(rw, 48000 * sizeof(float));
+    SDL_WriteLE16(rw, sizeof(float));
+    SDL_WriteLE16(rw, 32);
+    SDL_WriteLE16(rw, 0);
+    SDL_RWwrite(rw, "data", 4, 1);
+    SDL_WriteLE32(rw, sizeof(samples));
+    for(float sample : samples) {
+        std::uint32_t bits;
+        std::memcpy(&bits, &sample, sizeof(bits));
+        SDL_WriteLE32(rw, bits);
+    }
+    SDL_RWclose(rw);
+
+    {
+        // copied instead, so typed reads stay aligned
+        Wav wav { sdl.audio(), fileName, WavLoadMode::MAP };
+        EXPECT_FALSE(wav.isMapped());
+        EXPECT_EQ(wav.getAudioFormat(), AUDIO_F32);
+        ASSERT_EQ(wav.getSizeBytes(), sizeof(samples));
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(wav.begin()) % alignof(float), 0u);
+        EXPECT_FLOAT_EQ(reinterpret_cast<const float*>(wav.begin())[1], -0.5f);
+    }
+    std::remove(fileName);
+}
+
 TEST(SdlAudio, AudioDevice) {
     Sdl<SubsystemType::AUDIO> sdl;
 
@@ -99,3 +210,72 @@ TEST(SdlAudio, AudioDevice) {
 //    SDL_Delay(2000);
 
 }
+
+TEST(SdlAudio, AudioDeviceTyped) {
+    Sdl<SubsystemType::AUDIO> sdl;
+
+    std::atomic<int> numCallbacks {0};
+    auto callback = [&](AudioSpan<std::int16_t> stream) {
+        for(std::int16_t& sample : stream) {
+            sample = 0;
+        }
+        ++numCallbacks;
+    };
+
+    AudioDevice device {sdl.audio(), nullptr, false, 48000, AudioFormatConstant<AUDIO_S16SYS>{}, 2, 512, callback};
+    EXPECT_EQ(device.getObtainedSpec().format, AUDIO_S16SYS);
+
+    // the callable is not stored in the device, so moving the device is safe
+    AudioDevice moved = std::move(device);
+    moved.play();
+    for(int i = 0; i < 100 && numCallbacks == 0; ++i) {
+        SDL_Delay(10);
+    }
+    moved.pause();
+    EXPECT_GT(numCallbacks, 0);
+}
+
+TEST(SdlAudio, AudioDeviceRingBuffer) {
+    Sdl<SubsystemType::AUDIO> sdl;
+
+    AudioRingBuffer<AUDIO_F32SYS> ringBuffer {8192};
+
+    AudioDevice device {sdl.audio(), nullptr, 48000, 2, 1024, ringBuffer};
+
+    EXPECT_EQ(device.getObtainedSpec().format, AUDIO_F32SYS);
+}
+
+TEST(SdlAudio, AudioCallbackStats) {
+    Sdl<SubsystemType::AUDIO> sdl;
+
+    AudioHistogram histogram;
+    for(std::uint32_t value : {0u, 1u, 3u, 100u, 100u}) {
+        histogram.record(value);
+    }
+    AudioHistogram::Snapshot snapshot = histogram.getSnapshot();
+    EXPECT_EQ(snapshot.total, 5u);
+    EXPECT_EQ(snapshot.max, 100u);
+    EXPECT_EQ(snapshot.sum, 204u);
+    EXPECT_EQ(snapshot.counts[0], 1u);
+    EXPECT_EQ(snapshot.counts[7], 2u);
+    EXPECT_EQ(snapshot.getPercentile(0.5), 3u);
+    EXPECT_EQ(snapshot.getPercentile(0.99), 100u);
+
+    std::uint64_t frequency = SDL_GetPerformanceFrequency();
+    AudioCallbackStats stats;
+    stats.setDeadline(10000);
+    stats.record(frequency, frequency + frequency / 1000);
+    stats.record(2 * frequency, 2 * frequency + frequency / 50);
+    AudioCallbackStats::Snapshot callbackSnapshot = stats.getSnapshot();
+    EXPECT_EQ(callbackSnapshot.callbacks, 2u);
+    EXPECT_EQ(callbackSnapshot.missedDeadlines, 1u);
+    EXPECT_EQ(callbackSnapshot.intervals.total, 1u);
+    EXPECT_EQ(callbackSnapshot.margins.max, 9000u);
+
+    // an hour still fits in microseconds, six hours saturates
+    AudioCallbackStats longStats;
+    longStats.record(frequency, frequency + 3600 * frequency);
+    EXPECT_EQ(longStats.getSnapshot().durations.max, 3600000000u);
+    longStats.record(frequency, frequency + 6 * 3600 * frequency);
+    EXPECT_EQ(longStats.getSnapshot().durations.max, std::numeric_limits<std::uint32_t>::max());
+}
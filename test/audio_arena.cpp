@@ -0,0 +1,52 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "gtest/gtest.h"
+
+#include "sdlwrapper/audio_arena.hpp"
+
+#include <cstdint>
+
+using sdlwrapper::AudioArena;
+using sdlwrapper::AudioSpan;
+
+TEST(AudioArena, Allocate) {
+    SDL_AudioSpec spec {};
+    spec.samples = 100;
+    spec.channels = 2;
+
+    // two buffers of 800 bytes, each padded to 832
+    AudioArena arena {spec, 2};
+    EXPECT_EQ(arena.getCapacity(), 2u * 832);
+
+    AudioSpan<float> first = arena.allocate<float>(200);
+    AudioSpan<float> second = arena.allocate<float>(200);
+    ASSERT_NE(first.getData(), nullptr);
+    ASSERT_NE(second.getData(), nullptr);
+    EXPECT_EQ(first.getSize(), 200u);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(first.getData()) % 64, 0u);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(second.getData()) % 64, 0u);
+    EXPECT_GE(second.getData(), first.end());
+
+    AudioSpan<std::int16_t> full = arena.allocate<std::int16_t>(1);
+    EXPECT_EQ(full.getData(), nullptr);
+    EXPECT_EQ(full.getSize(), 0u);
+    EXPECT_EQ(arena.getFailures(), 1u);
+
+    arena.reset();
+    EXPECT_EQ(arena.getUsed(), 0u);
+    EXPECT_EQ(arena.getHighWater(), 2u * 832);
+    EXPECT_EQ(arena.allocate<float>(200).getData(), first.getData());
+}
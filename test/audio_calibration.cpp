@@ -0,0 +1,81 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "gtest/gtest.h"
+
+#include "sdlwrapper/audio_calibration.hpp"
+#include "sdlwrapper/sdl.hpp"
+
+#include <cstdio>
+
+using sdlwrapper::Sdl;
+using sdlwrapper::SubsystemType;
+using sdlwrapper::AudioCalibrationCache;
+using sdlwrapper::AudioCalibrationOptions;
+using sdlwrapper::AudioCalibrationResult;
+
+TEST(AudioCalibration, Calibrate) {
+    Sdl<SubsystemType::AUDIO> sdl;
+
+    // loose targets, since test machines are busy
+    AudioCalibrationOptions options;
+    options.maxSamples = 2048;
+    options.minSamples = 512;
+    options.windowMs = 100;
+    options.maxJitter = 1.0;
+    options.maxUnderruns = 100;
+
+    int loads = 0;
+    options.load = [](void* userdata, std::uint8_t*, int) {
+        ++*reinterpret_cast<int*>(userdata);
+    };
+    options.userdata = &loads;
+
+    AudioCalibrationResult result = sdlwrapper::calibrateAudioDevice(sdl.audio(), nullptr, options);
+    EXPECT_TRUE(result.stable);
+    EXPECT_GE(result.samples, 512);
+    EXPECT_LE(result.samples, 2048);
+    EXPECT_GT(result.obtainedSamples, 0);
+    EXPECT_EQ(result.latencyUs, result.obtainedSamples * 1000000u / 48000);
+    EXPECT_GT(loads, 0);
+
+    // nothing passes an impossible target, so the largest size is returned
+    options.maxJitter = -1.0;
+    result = sdlwrapper::calibrateAudioDevice(sdl.audio(), nullptr, options);
+    EXPECT_FALSE(result.stable);
+    EXPECT_EQ(result.samples, 2048);
+}
+
+TEST(AudioCalibration, Cache) {
+    const char* fileName = "audio_calibration_test.txt";
+    std::remove(fileName);
+
+    {
+        AudioCalibrationCache cache {fileName};
+        EXPECT_EQ(cache.find("Speakers"), 0);
+        cache.store("Speakers", 256);
+        cache.store("USB Headset (2)", 1024);
+        cache.store(nullptr, 512);
+        EXPECT_EQ(cache.find("Speakers"), 256);
+    }
+
+    AudioCalibrationCache loaded {fileName};
+    EXPECT_EQ(loaded.find("Speakers"), 256);
+    EXPECT_EQ(loaded.find("USB Headset (2)"), 1024);
+    EXPECT_EQ(loaded.find(nullptr), 512);
+    EXPECT_EQ(loaded.find("Other"), 0);
+
+    std::remove(fileName);
+}
@@ -0,0 +1,92 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "gtest/gtest.h"
+
+#include "sdlwrapper/audio_clock.hpp"
+#include "sdlwrapper/queue_streamer.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+using sdlwrapper::Sdl;
+using sdlwrapper::SubsystemType;
+using sdlwrapper::AudioDevice;
+using sdlwrapper::AudioClock;
+
+TEST(AudioClock, Callback) {
+    AudioClock clock {48000, AUDIO_F32SYS, 2};
+    EXPECT_EQ(clock.getFrames(), 0u);
+
+    std::vector<float> buffer(2 * 480, 1.0f);
+    AudioClock::callback(&clock, reinterpret_cast<std::uint8_t*>(buffer.data()), static_cast<int>(buffer.size() * sizeof(float)));
+    EXPECT_FLOAT_EQ(buffer[0], 0.0f);
+
+    // interpolates through the buffer, then holds at its end
+    std::uint64_t frames = clock.getFrames();
+    EXPECT_LE(frames, 480u);
+    SDL_Delay(5);
+    EXPECT_GE(clock.getFrames(), frames);
+    SDL_Delay(20);
+    EXPECT_EQ(clock.getFrames(), 480u);
+    EXPECT_DOUBLE_EQ(clock.getSeconds(), 0.01);
+
+    // starts the next buffer where the last one ended
+    clock.advance(480);
+    EXPECT_GE(clock.getFrames(), 480u);
+    SDL_Delay(20);
+    EXPECT_EQ(clock.getFrames(), 960u);
+}
+
+#ifdef SDLWRAPPER_AUDIO_SUPPORTS_NONCALLBACK
+
+using sdlwrapper::QueueStreamer;
+
+TEST(AudioClock, Queue) {
+    Sdl<SubsystemType::AUDIO> sdl;
+
+    AudioDevice device {sdl.audio(), nullptr, false, 48000, AUDIO_S16SYS, 2, 256};
+    AudioClock clock {48000, AUDIO_S16SYS, 2};
+
+    std::atomic<std::uint64_t> produced {0};
+    auto source = [&](std::uint8_t* data, std::uint32_t len) {
+        std::memset(data, 0, len);
+        produced += len;
+        return len;
+    };
+
+    {
+        QueueStreamer streamer {device, source, 20, 40, &clock};
+        SDL_Delay(10);
+        EXPECT_EQ(clock.getFrames(), 0u);
+
+        device.play();
+        std::uint64_t last = 0;
+        for(int i = 0; i < 100; ++i) {
+            std::uint64_t frames = clock.getFrames();
+            EXPECT_GE(frames, last);
+            last = frames;
+            SDL_Delay(1);
+        }
+        device.pause();
+    }
+
+    // never ahead of the samples produced
+    EXPECT_GT(clock.getFrames(), 0u);
+    EXPECT_LE(clock.getFrames(), produced / 4);
+}
+
+#endif // SDLWRAPPER_AUDIO_SUPPORTS_NONCALLBACK
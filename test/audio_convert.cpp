@@ -0,0 +1,132 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "gtest/gtest.h"
+
+#include "sdlwrapper/audio_convert.hpp"
+
+#include <cstdint>
+#include <vector>
+
+using sdlwrapper::Sdl;
+using sdlwrapper::SubsystemType;
+using sdlwrapper::SdlError;
+using sdlwrapper::Wav;
+using sdlwrapper::convert;
+
+TEST(AudioConvert, IntegerToFloat) {
+    std::int16_t src[10] {0, 16384, -16384, -32768, 32767, 1, -1, 8192, 0, -8192};
+    float dst[10];
+    convert<AUDIO_S16SYS, AUDIO_F32SYS>(src, dst, 10);
+    EXPECT_EQ(dst[0], 0.0f);
+    EXPECT_EQ(dst[1], 0.5f);
+    EXPECT_EQ(dst[2], -0.5f);
+    EXPECT_EQ(dst[3], -1.0f);
+    EXPECT_EQ(dst[9], -0.25f);
+
+    std::uint8_t u8[3] {0x80, 0x00, 0xC0};
+    convert<AUDIO_U8, AUDIO_F32SYS>(u8, dst, 3);
+    EXPECT_EQ(dst[0], 0.0f);
+    EXPECT_EQ(dst[1], -1.0f);
+    EXPECT_EQ(dst[2], 0.5f);
+}
+
+TEST(AudioConvert, FloatToInteger) {
+    float src[10] {0.0f, 0.5f, -0.5f, -1.0f, 1.0f, 2.0f, -2.0f, 0.25f, -0.25f, 0.0f};
+    std::int16_t dst[10];
+    convert<AUDIO_F32SYS, AUDIO_S16SYS>(src, dst, 10);
+    EXPECT_EQ(dst[0], 0);
+    EXPECT_EQ(dst[1], 16384);
+    EXPECT_EQ(dst[2], -16384);
+    EXPECT_EQ(dst[3], -32768);
+    EXPECT_EQ(dst[4], 32767);
+    EXPECT_EQ(dst[5], 32767);
+    EXPECT_EQ(dst[6], -32768);
+    EXPECT_EQ(dst[9], 0);
+
+    // past the int32 range too, in both the SIMD and the scalar loops
+    float overRange[10] {70000.0f, -70000.0f, 3e9f, -3e9f, 1.0f, 2.0f, 0.0f, 0.0f, 70000.0f, -70000.0f};
+    convert<AUDIO_F32SYS, AUDIO_S16SYS>(overRange, dst, 10);
+    EXPECT_EQ(dst[0], 32767);
+    EXPECT_EQ(dst[1], -32768);
+    EXPECT_EQ(dst[2], 32767);
+    EXPECT_EQ(dst[3], -32768);
+    EXPECT_EQ(dst[8], 32767);
+    EXPECT_EQ(dst[9], -32768);
+
+    std::int32_t s32[2];
+    convert<AUDIO_F32SYS, AUDIO_S32SYS>(src + 4, s32, 2);
+    EXPECT_GT(s32[0], 2147483000);
+    EXPECT_GT(s32[1], 2147483000);
+
+    std::uint8_t u8[4];
+    convert<AUDIO_F32SYS, AUDIO_U8>(src, u8, 4);
+    EXPECT_EQ(u8[0], 0x80);
+    EXPECT_EQ(u8[1], 0xC0);
+    EXPECT_EQ(u8[2], 0x40);
+    EXPECT_EQ(u8[3], 0x00);
+}
+
+TEST(AudioConvert, IntegerToInteger) {
+    std::uint8_t u8[2] {0x80, 0xFF};
+    std::int16_t s16[2];
+    convert<AUDIO_U8, AUDIO_S16SYS>(u8, s16, 2);
+    EXPECT_EQ(s16[0], 0);
+    EXPECT_EQ(s16[1], 0x7F00);
+
+    std::int16_t swapped[2];
+    convert<AUDIO_S16SYS, AUDIO_S16SYS ^ SDL_AUDIO_MASK_ENDIAN>(s16, swapped, 2);
+    EXPECT_EQ(static_cast<std::uint16_t>(swapped[1]), 0x007F);
+
+    std::int8_t s8[2];
+    convert<AUDIO_S16SYS ^ SDL_AUDIO_MASK_ENDIAN, AUDIO_S8>(swapped, s8, 2);
+    EXPECT_EQ(s8[0], 0);
+    EXPECT_EQ(s8[1], 0x7F);
+}
+
+TEST(AudioConvert, RuntimeDispatch) {
+    std::vector<std::int16_t> src(101);
+    for(std::size_t i = 0; i < src.size(); ++i) {
+        src[i] = static_cast<std::int16_t>(i * 640 - 32000);
+    }
+
+    std::vector<float> compileTime(src.size());
+    std::vector<float> runTime(src.size());
+    convert<AUDIO_S16SYS, AUDIO_F32MSB>(src.data(), compileTime.data(), src.size());
+    convert(AUDIO_S16SYS, AUDIO_F32MSB, src.data(), runTime.data(), src.size());
+    EXPECT_EQ(compileTime, runTime);
+
+    // round trip through the SIMD paths and back
+    std::vector<float> native(src.size());
+    std::vector<std::int16_t> roundTrip(src.size());
+    convert(AUDIO_F32MSB, AUDIO_F32SYS, runTime.data(), native.data(), src.size());
+    convert(AUDIO_F32SYS, AUDIO_S16SYS, native.data(), roundTrip.data(), src.size());
+    EXPECT_EQ(src, roundTrip);
+
+    EXPECT_THROW(convert((AUDIO_F32SYS & ~SDL_AUDIO_MASK_BITSIZE) | 64, AUDIO_S16SYS, native.data(), roundTrip.data(), 1), SdlError);
+}
+
+TEST(AudioConvert, Wav) {
+    Sdl<SubsystemType::AUDIO> sdl;
+
+    Wav wav { sdl.audio(), SDLWRAPPER_TEST_RES_DIR "/para_open-01.wav" };
+
+    std::size_t count = wav.getSizeBytes() / (SDL_AUDIO_BITSIZE(wav.getAudioFormat()) / 8);
+    std::vector<std::int16_t> s16(count);
+    convert(wav.getAudioFormat(), AUDIO_S16SYS, wav.begin(), s16.data(), count);
+
+    const float* f32 = reinterpret_cast<const float*>(wav.begin());
+    EXPECT_EQ(s16[count / 2], static_cast<std::int16_t>(f32[count / 2] * 32768.0f));
+}
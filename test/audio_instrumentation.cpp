@@ -0,0 +1,78 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+// built into its own test executable, with SDLWRAPPER_AUDIO_INSTRUMENTATION defined for every translation unit
+
+#include "gtest/gtest.h"
+
+#include "sdlwrapper/audio.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+using sdlwrapper::Sdl;
+using sdlwrapper::SubsystemType;
+using sdlwrapper::AudioCallbackStats;
+using sdlwrapper::AudioDevice;
+using sdlwrapper::AudioFormatConstant;
+using sdlwrapper::AudioSpan;
+
+namespace
+{
+
+void rawCallback(void* userdata, std::uint8_t* stream, int len)
+{
+    std::memset(stream, 0, len);
+    ++*static_cast<std::atomic<int>*>(userdata);
+}
+
+} // namespace
+
+TEST(AudioInstrumentation, TypedCallback) {
+    Sdl<SubsystemType::AUDIO> sdl;
+
+    std::atomic<int> numCallbacks {0};
+    auto callback = [&](AudioSpan<float> stream) {
+        std::fill(stream.begin(), stream.end(), 0.0f);
+        ++numCallbacks;
+    };
+    AudioDevice device {sdl.audio(), nullptr, false, 48000, AudioFormatConstant<AUDIO_F32SYS>{}, 2, 480, callback};
+    EXPECT_EQ(device.getCallbackStats().getSnapshot().deadline, 10000u);
+    device.play();
+    for(int i = 0; i < 100 && numCallbacks < 2; ++i) {
+        SDL_Delay(10);
+    }
+    device.pause();
+    EXPECT_GE(device.getCallbackStats().getSnapshot().callbacks, 2u);
+}
+
+TEST(AudioInstrumentation, RawCallback) {
+    Sdl<SubsystemType::AUDIO> sdl;
+
+    // the userdata still reaches the callback through the wrapper
+    std::atomic<int> numCallbacks {0};
+    AudioDevice device {sdl.audio(), nullptr, false, 48000, AUDIO_S16SYS, 2, 960, rawCallback, &numCallbacks};
+    EXPECT_EQ(device.getCallbackStats().getSnapshot().deadline, 20000u);
+    device.play();
+    for(int i = 0; i < 100 && numCallbacks < 2; ++i) {
+        SDL_Delay(10);
+    }
+    device.pause();
+
+    AudioCallbackStats::Snapshot snapshot = device.getCallbackStats().getSnapshot();
+    EXPECT_GE(snapshot.callbacks, 2u);
+    EXPECT_GE(snapshot.intervals.total, 1u);
+}
@@ -0,0 +1,130 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+// built into its own test executable, with SDLWRAPPER_AUDIO_RT_CHECK defined for every translation unit
+#define SDLWRAPPER_AUDIO_RT_CHECK_OPERATOR_NEW
+
+#include "gtest/gtest.h"
+
+#include "sdlwrapper/audio_arena.hpp"
+#include "sdlwrapper/audio_rt_check.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+using sdlwrapper::Sdl;
+using sdlwrapper::SubsystemType;
+using sdlwrapper::AudioArena;
+using sdlwrapper::AudioDevice;
+using sdlwrapper::AudioFormatConstant;
+using sdlwrapper::AudioRtViolation;
+using sdlwrapper::AudioSpan;
+
+namespace
+{
+
+std::atomic<int> allocations {0};
+std::atomic<int> locks {0};
+
+void countViolation(AudioRtViolation violation, const char*)
+{
+    if(violation == AudioRtViolation::ALLOCATION) {
+        ++allocations;
+    }
+    else if(violation == AudioRtViolation::LOCK) {
+        ++locks;
+    }
+}
+
+// like the ring buffers' cache line aligned members
+struct alignas(64) OverAligned
+{
+    float values[16];
+};
+
+void runCallbacks(AudioDevice& device, std::atomic<int>& numCallbacks)
+{
+    device.play();
+    for(int i = 0; i < 100 && numCallbacks < 3; ++i) {
+        SDL_Delay(5);
+    }
+    device.pause();
+}
+
+template <typename Callable>
+void runCallbacks(const sdlwrapper::AudioSubsystem& audio, Callable& callback, std::atomic<int>& numCallbacks)
+{
+    AudioDevice device {audio, nullptr, false, 48000, AudioFormatConstant<AUDIO_F32SYS>{}, 2, 256, callback};
+    runCallbacks(device, numCallbacks);
+}
+
+} // namespace
+
+TEST(AudioRtCheck, Violations) {
+    Sdl<SubsystemType::AUDIO> sdl;
+    sdlwrapper::setAudioRtViolationHandler(countViolation);
+
+    // only callbacks are checked
+    EXPECT_FALSE(sdlwrapper::isAudioThread());
+    std::vector<float> outside(16);
+    sdlwrapper::checkAudioRt(AudioRtViolation::LOCK, "test");
+    EXPECT_EQ(sdlwrapper::getAudioRtViolations(), 0u);
+
+    std::atomic<int> numCallbacks {0};
+    auto allocating = [&](AudioSpan<float> stream) {
+        std::vector<float> scratch(stream.getSize());
+        sdlwrapper::checkAudioRt(AudioRtViolation::LOCK, "test");
+        ++numCallbacks;
+    };
+    runCallbacks(sdl.audio(), allocating, numCallbacks);
+    EXPECT_GE(allocations, numCallbacks);
+    EXPECT_GE(locks, numCallbacks);
+
+    allocations = 0;
+    numCallbacks = 0;
+    auto overAligned = [&](AudioSpan<float>) {
+        std::unique_ptr<OverAligned> scratch {new OverAligned{}};
+        ++numCallbacks;
+    };
+    runCallbacks(sdl.audio(), overAligned, numCallbacks);
+    EXPECT_GE(allocations, numCallbacks);
+
+    allocations = 0;
+    locks = 0;
+    numCallbacks = 0;
+    std::unique_ptr<AudioArena> arena;
+    auto clean = [&](AudioSpan<float> stream) {
+        arena->reset();
+        AudioSpan<float> scratch = arena->allocate<float>(stream.getSize());
+        std::fill(scratch.begin(), scratch.end(), 0.0f);
+        std::copy(scratch.begin(), scratch.end(), stream.begin());
+        ++numCallbacks;
+    };
+    {
+        AudioDevice device {sdl.audio(), nullptr, false, 48000, AudioFormatConstant<AUDIO_F32SYS>{}, 2, 256, clean};
+        // sized for the buffers the device really asks for, before it plays
+        arena.reset(new AudioArena{device.getObtainedSpec(), 1});
+        runCallbacks(device, numCallbacks);
+    }
+    EXPECT_GT(numCallbacks, 0);
+    EXPECT_EQ(allocations, 0);
+    EXPECT_EQ(locks, 0);
+    EXPECT_EQ(arena->getFailures(), 0u);
+
+    sdlwrapper::setAudioRtViolationHandler(nullptr);
+}
@@ -0,0 +1,172 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "gtest/gtest.h"
+
+#include "sdlwrapper/axis_processor.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+using sdlwrapper::AxisCurve;
+using sdlwrapper::AxisProcessor;
+using sdlwrapper::AxisSettings;
+using sdlwrapper::DeadzoneShape;
+using sdlwrapper::GameController;
+using sdlwrapper::GameControllerState;
+
+namespace
+{
+
+// one controller at a time, the obvious way
+float shape(float magnitude, const AxisSettings& settings)
+{
+    float deflection = (magnitude - settings.innerDeadzone) / (settings.outerDeadzone - settings.innerDeadzone);
+    return settings.curve.evaluate(std::min(std::max(deflection, 0.0f), 1.0f));
+}
+
+void expectStick(const AxisProcessor& processor, std::size_t index, GameController::Axis axisX, GameController::Axis axisY,
+                 std::int16_t rawX, std::int16_t rawY, const AxisSettings& settings)
+{
+    float x = sdlwrapper::detail::normalizeAxis(rawX);
+    float y = sdlwrapper::detail::normalizeAxis(rawY);
+    float expectedX, expectedY;
+    if(settings.shape == DeadzoneShape::RADIAL) {
+        float magnitude = std::sqrt(x * x + y * y);
+        float scale = magnitude > 0.0f ? shape(magnitude, settings) / magnitude : 0.0f;
+        expectedX = x * scale;
+        expectedY = y * scale;
+    }
+    else {
+        expectedX = std::copysign(shape(std::abs(x), settings), x);
+        expectedY = std::copysign(shape(std::abs(y), settings), y);
+    }
+    EXPECT_NEAR(processor.get(axisX, index), std::min(std::max(expectedX, -1.0f), 1.0f), 1e-4f) << index;
+    EXPECT_NEAR(processor.get(axisY, index), std::min(std::max(expectedY, -1.0f), 1.0f), 1e-4f) << index;
+}
+
+std::vector<GameControllerState> makeStates(std::size_t count)
+{
+    std::vector<GameControllerState> states(count);
+    std::uint32_t seed = 12345;
+    for(GameControllerState& state : states) {
+        for(std::int16_t& axis : state.axes) {
+            seed = seed * 1664525u + 1013904223u;
+            axis = static_cast<std::int16_t>(seed >> 16);
+        }
+        // triggers only go from 0 up
+        state.axes[SDL_CONTROLLER_AXIS_TRIGGERLEFT] &= 0x7fff;
+        state.axes[SDL_CONTROLLER_AXIS_TRIGGERRIGHT] &= 0x7fff;
+    }
+    // rest, and every extreme
+    states[0].axes = {};
+    states[1].axes = {{32767, 0, 0, -32768, 32767, 0}};
+    return states;
+}
+
+void expectAll(const AxisProcessor& processor, const std::vector<GameControllerState>& states,
+               const AxisSettings& sticks, const AxisSettings& triggers)
+{
+    ASSERT_EQ(processor.getCount(), states.size());
+    for(std::size_t i = 0; i < states.size(); ++i) {
+        const auto& axes = states[i].axes;
+        expectStick(processor, i, GameController::Axis::LEFTX, GameController::Axis::LEFTY,
+                    axes[SDL_CONTROLLER_AXIS_LEFTX], axes[SDL_CONTROLLER_AXIS_LEFTY], sticks);
+        expectStick(processor, i, GameController::Axis::RIGHTX, GameController::Axis::RIGHTY,
+                    axes[SDL_CONTROLLER_AXIS_RIGHTX], axes[SDL_CONTROLLER_AXIS_RIGHTY], sticks);
+
+        float left = shape(sdlwrapper::detail::normalizeAxis(axes[SDL_CONTROLLER_AXIS_TRIGGERLEFT]), triggers);
+        float right = shape(sdlwrapper::detail::normalizeAxis(axes[SDL_CONTROLLER_AXIS_TRIGGERRIGHT]), triggers);
+        EXPECT_NEAR(processor.get(GameController::Axis::TRIGGERLEFT, i), left, 1e-4f) << i;
+        EXPECT_NEAR(processor.get(GameController::Axis::TRIGGERRIGHT, i), right, 1e-4f) << i;
+    }
+}
+
+} // namespace
+
+TEST(AxisProcessor, Linear) {
+    // not a multiple of 4, so the last vector is padded
+    std::vector<GameControllerState> states = makeStates(7);
+
+    AxisProcessor processor;
+    processor.process(states.data(), states.size());
+    expectAll(processor, states, {}, {});
+
+    EXPECT_FLOAT_EQ(processor.get(GameController::Axis::LEFTX, 0), 0.0f);
+    EXPECT_FLOAT_EQ(processor.get(GameController::Axis::LEFTX, 1), 1.0f);
+    EXPECT_FLOAT_EQ(processor.get(GameController::Axis::RIGHTY, 1), -1.0f);
+    EXPECT_FLOAT_EQ(processor.get(GameController::Axis::TRIGGERLEFT, 1), 1.0f);
+}
+
+TEST(AxisProcessor, Deadzones) {
+    std::vector<GameControllerState> states = makeStates(13);
+
+    AxisSettings sticks;
+    sticks.innerDeadzone = 0.2f;
+    sticks.outerDeadzone = 0.9f;
+    AxisSettings triggers;
+    triggers.innerDeadzone = 0.1f;
+
+    AxisProcessor processor {sticks, triggers};
+    processor.process(states.data(), states.size());
+    expectAll(processor, states, sticks, triggers);
+
+    // y alone is inside the inner deadzone, which only radial keeps
+    GameControllerState state;
+    state.axes[SDL_CONTROLLER_AXIS_LEFTX] = 32767;
+    state.axes[SDL_CONTROLLER_AXIS_LEFTY] = 3000;
+    processor.process(&state, 1);
+    EXPECT_GT(processor.get(GameController::Axis::LEFTY, 0), 0.0f);
+
+    sticks.shape = DeadzoneShape::AXIAL;
+    processor.setSticks(sticks);
+    processor.process(&state, 1);
+    EXPECT_FLOAT_EQ(processor.get(GameController::Axis::LEFTX, 0), 1.0f);
+    EXPECT_FLOAT_EQ(processor.get(GameController::Axis::LEFTY, 0), 0.0f);
+
+    processor.process(states.data(), states.size());
+    expectAll(processor, states, sticks, triggers);
+}
+
+TEST(AxisProcessor, Curves) {
+    std::vector<GameControllerState> states = makeStates(33);
+
+    AxisSettings sticks;
+    sticks.innerDeadzone = 0.1f;
+    sticks.curve = AxisCurve::polynomial(0.2f, 0.0f, 0.8f);
+
+    const float table[] = {0.0f, 0.05f, 0.2f, 0.5f, 1.0f};
+    AxisSettings triggers;
+    triggers.curve = AxisCurve::table(table, 5);
+    EXPECT_FLOAT_EQ(triggers.curve.evaluate(0.5f), 0.2f);
+    EXPECT_FLOAT_EQ(triggers.curve.evaluate(0.625f), 0.35f);
+
+    AxisProcessor processor {sticks, triggers, 4};
+    processor.process(states.data(), states.size());
+    expectAll(processor, states, sticks, triggers);
+
+    sticks.shape = DeadzoneShape::AXIAL;
+    sticks.curve = AxisCurve::table(table, 5);
+    processor.setSticks(sticks);
+    processor.process(states.data(), states.size());
+    expectAll(processor, states, sticks, triggers);
+
+    // shrinking reuses the arrays
+    processor.process(states.data(), 2);
+    EXPECT_EQ(processor.getCount(), 2u);
+    EXPECT_FLOAT_EQ(processor.get(GameController::Axis::RIGHTY, 1), -1.0f);
+}
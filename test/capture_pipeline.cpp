@@ -0,0 +1,90 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "gtest/gtest.h"
+
+#include "sdlwrapper/audio.hpp"
+#include "sdlwrapper/capture_pipeline.hpp"
+
+#include <numeric>
+#include <vector>
+
+using sdlwrapper::Sdl;
+using sdlwrapper::SubsystemType;
+using sdlwrapper::AudioDevice;
+using sdlwrapper::CapturePipeline;
+
+TEST(CapturePipeline, Blocks) {
+    CapturePipeline pipeline {16, 2};
+
+    std::vector<std::uint8_t> stream(24);
+    std::iota(stream.begin(), stream.end(), 0);
+
+    EXPECT_FALSE(pipeline.pop());
+
+    // one full block, and half of the next
+    CapturePipeline::callback(&pipeline, stream.data(), 24);
+    CapturePipeline::Block first = pipeline.pop();
+    ASSERT_TRUE(first);
+    EXPECT_EQ(first.getSize(), 16u);
+    EXPECT_TRUE(std::equal(first.getData(), first.getData() + 16, stream.begin()));
+    EXPECT_FALSE(pipeline.pop());
+
+    // fills the second block, then no block is free for the rest
+    CapturePipeline::callback(&pipeline, stream.data(), 24);
+    EXPECT_EQ(pipeline.getOverruns(), 1u);
+    EXPECT_EQ(pipeline.getDroppedBytes(), 16u);
+
+    CapturePipeline::Block second = pipeline.pop();
+    ASSERT_TRUE(second);
+    EXPECT_EQ(second.getData()[7], 23);
+    EXPECT_EQ(second.getData()[8], 0);
+
+    // releasing a block makes room again
+    first.release();
+    EXPECT_FALSE(first);
+    CapturePipeline::callback(&pipeline, stream.data(), 4);
+    EXPECT_EQ(pipeline.getOverruns(), 1u);
+
+    pipeline.flush();
+    CapturePipeline::Block partial = pipeline.pop();
+    ASSERT_TRUE(partial);
+    EXPECT_EQ(partial.getSize(), 4u);
+}
+
+TEST(CapturePipeline, AudioDevice) {
+    Sdl<SubsystemType::AUDIO> sdl;
+
+    // nothing to record from, on headless machines
+    if(AudioDevice::getNumAudioDevices(sdl.audio(), true) <= 0) {
+        return;
+    }
+
+    CapturePipeline pipeline {4096, 8};
+    AudioDevice device {sdl.audio(), nullptr, true, 48000, AUDIO_S16SYS, 1, 1024, CapturePipeline::callback, &pipeline};
+
+    device.play();
+    std::uint32_t received = 0;
+    for(int i = 0; i < 100 && received < 4096 * 2; ++i) {
+        while(CapturePipeline::Block block = pipeline.pop()) {
+            received += block.getSize();
+        }
+        SDL_Delay(10);
+    }
+    device.pause();
+
+    EXPECT_GE(received, 4096u * 2);
+    EXPECT_EQ(pipeline.getOverruns(), 0u);
+}
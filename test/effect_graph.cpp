@@ -0,0 +1,108 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "gtest/gtest.h"
+
+#include "sdlwrapper/effect_graph.hpp"
+
+#include <cmath>
+#include <vector>
+
+using sdlwrapper::BiquadType;
+using sdlwrapper::EffectGraph;
+
+TEST(EffectGraph, Routing) {
+    EffectGraph graph {48000, 2};
+
+    // an empty graph passes audio through, across several blocks
+    std::vector<float> samples(1000 * 2);
+    for(std::size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = (i % 2 == 0 ? 0.25f : -0.5f);
+    }
+    graph.process(samples.data(), 1000);
+    EXPECT_FLOAT_EQ(samples[0], 0.25f);
+    EXPECT_FLOAT_EQ(samples[1], -0.5f);
+    EXPECT_FLOAT_EQ(samples[1998], 0.25f);
+    EXPECT_FLOAT_EQ(samples[1999], -0.5f);
+
+    // input is both returned and sent through a bus at half gain
+    EffectGraph::BusId reverb = graph.addBus();
+    graph.addSend(EffectGraph::INPUT, reverb, 0.5f);
+    EffectGraph::EffectId master = graph.addGain(EffectGraph::MASTER, 2.0f);
+    graph.commit();
+
+    std::fill(samples.begin(), samples.end(), 0.25f);
+    graph.process(samples.data(), 1000);
+    EXPECT_FLOAT_EQ(samples[0], 0.75f);
+    EXPECT_FLOAT_EQ(samples[1999], 0.75f);
+
+    // live gain changes ramp rather than jump
+    graph.setGain(master, 0.0f);
+    std::fill(samples.begin(), samples.end(), 0.25f);
+    graph.process(samples.data(), 1000);
+    EXPECT_GT(samples[0], 0.7f);
+    EXPECT_LT(samples[1999], samples[0]);
+
+    // a send back into its own input is a cycle
+    graph.addSend(reverb, EffectGraph::INPUT);
+    EXPECT_THROW(graph.commit(), sdlwrapper::SdlError);
+}
+
+TEST(EffectGraph, Effects) {
+    EffectGraph graph {48000, 1};
+    graph.addBiquad(EffectGraph::INPUT, BiquadType::LOW_PASS, 1000.0f);
+    EffectGraph::EffectId limiter = graph.addLimiter(EffectGraph::MASTER, 0.5f);
+    graph.commit();
+
+    // a low pass passes DC, settling to the input level
+    std::vector<float> samples(4800, 0.25f);
+    graph.process(samples.data(), samples.size());
+    EXPECT_NEAR(samples.back(), 0.25f, 1e-3f);
+
+    // and removes the highest frequency
+    for(std::size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = (i % 2 == 0 ? 0.25f : -0.25f);
+    }
+    graph.process(samples.data(), samples.size());
+    EXPECT_NEAR(samples.back(), 0.0f, 1e-3f);
+
+    // the limiter holds peaks to its threshold
+    graph.setLimiterThreshold(limiter, 0.1f);
+    for(std::size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = std::sin(i * 0.01f);
+    }
+    graph.process(samples.data(), samples.size());
+    float peak = 0.0f;
+    for(float sample : samples) {
+        peak = std::max(peak, std::abs(sample));
+    }
+    EXPECT_LE(peak, 0.1f + 1e-6f);
+    EXPECT_GT(peak, 0.05f);
+
+}
+
+TEST(EffectGraph, Callback) {
+    // the source fills the stream before the graph runs
+    EffectGraph graph {48000, 2, [](void*, std::uint8_t* stream, int len) {
+        std::fill(reinterpret_cast<float*>(stream), reinterpret_cast<float*>(stream + len), 2.0f);
+    }};
+    graph.addLimiter(EffectGraph::MASTER);
+    graph.commit();
+
+    std::vector<float> samples(512 * 2);
+    EffectGraph::callback(&graph, reinterpret_cast<std::uint8_t*>(samples.data()), static_cast<int>(samples.size() * sizeof(float)));
+    EXPECT_FLOAT_EQ(samples[0], 1.0f);
+    EXPECT_FLOAT_EQ(samples[1023], 1.0f);
+}
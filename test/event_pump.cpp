@@ -0,0 +1,73 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "gtest/gtest.h"
+
+#include "sdlwrapper/event_pump.hpp"
+
+using sdlwrapper::Sdl;
+using sdlwrapper::SubsystemType;
+using sdlwrapper::EventPump;
+using sdlwrapper::EventPumpStats;
+
+TEST(EventPump, Sort) {
+    Sdl<SubsystemType::EVENTS> sdl;
+    SDL_FlushEvents(SDL_FIRSTEVENT, SDL_LASTEVENT);
+
+    EventPump pump {sdl.events(), 64};
+
+    // an input storm, several batches long
+    for(int i = 0; i < 1000; ++i) {
+        SDL_Event event {};
+        event.type = i % 4 == 0 ? SDL_CONTROLLERAXISMOTION : SDL_CONTROLLERBUTTONDOWN;
+        event.caxis.value = static_cast<Sint16>(i);
+        SDL_PushEvent(&event);
+    }
+    SDL_Event event {};
+    event.type = SDL_KEYDOWN;
+    SDL_PushEvent(&event);
+    event.type = SDL_WINDOWEVENT;
+    SDL_PushEvent(&event);
+    event.type = SDL_USEREVENT;
+    event.user.code = 7;
+    SDL_PushEvent(&event);
+    event.type = SDL_QUIT;
+    SDL_PushEvent(&event);
+
+    const EventPumpStats& stats = pump.pump();
+    EXPECT_EQ(stats.events, 1004u);
+    EXPECT_EQ(stats.batches, 16u);
+    EXPECT_EQ(stats.controllerEvents, 1000u);
+    EXPECT_EQ(stats.keyboardEvents, 1u);
+    EXPECT_EQ(stats.windowEvents, 1u);
+    EXPECT_EQ(stats.userEvents, 1u);
+    EXPECT_EQ(stats.otherEvents, 1u);
+    EXPECT_EQ(stats.peakEvents, 1004u);
+
+    // queue order within each category
+    ASSERT_EQ(pump.getControllerAxisEvents().size(), 250u);
+    EXPECT_EQ(pump.getControllerAxisEvents()[1].value, 4);
+    EXPECT_EQ(pump.getControllerButtonEvents().size(), 750u);
+    EXPECT_EQ(pump.getUserEvents()[0].code, 7);
+    EXPECT_TRUE(pump.isQuitRequested());
+
+    // the next frame replaces the last
+    pump.pump();
+    EXPECT_EQ(pump.getStats().events, 0u);
+    EXPECT_EQ(pump.getStats().batches, 1u);
+    EXPECT_EQ(pump.getStats().peakEvents, 1004u);
+    EXPECT_TRUE(pump.getControllerAxisEvents().empty());
+    EXPECT_FALSE(pump.isQuitRequested());
+}
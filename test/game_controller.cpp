@@ -20,6 +20,7 @@
 using sdlwrapper::Sdl;
 using sdlwrapper::SubsystemType;
 using sdlwrapper::GameController;
+using sdlwrapper::GameControllerState;
 
 TEST(GameController, Open) {
 
@@ -31,3 +32,33 @@ TEST(GameController, Open) {
         }
     }
 }
+
+TEST(GameController, Snapshot) {
+
+    Sdl<SubsystemType::GAMECONTROLLER> sdl;
+
+    for(int i = 0; i < SDL_NumJoysticks(); ++i) {
+        if(SDL_IsGameController(i)) {
+            GameController controller { sdl.gamecontroller(), i };
+            GameControllerState state = controller.snapshot();
+            EXPECT_EQ(state.pressed, state.buttons);
+            EXPECT_EQ(controller.snapshot(state).pressed & state.buttons, 0u);
+        }
+    }
+
+    // edges come from the previous snapshot's buttons
+    GameControllerState previous;
+    previous.buttons = GameControllerState::getMask(GameController::Button::A) | GameControllerState::getMask(GameController::Button::B);
+
+    GameControllerState state;
+    state.buttons = GameControllerState::getMask(GameController::Button::B) | GameControllerState::getMask(GameController::Button::DPAD_UP);
+    state.updateEdges(previous);
+    state.axes[SDL_CONTROLLER_AXIS_TRIGGERLEFT] = -32768;
+
+    EXPECT_TRUE(state.isDown(GameController::Button::B));
+    EXPECT_FALSE(state.wasPressed(GameController::Button::B));
+    EXPECT_TRUE(state.wasPressed(GameController::Button::DPAD_UP));
+    EXPECT_TRUE(state.wasReleased(GameController::Button::A));
+    EXPECT_FALSE(state.isDown(GameController::Button::A));
+    EXPECT_FLOAT_EQ(state.getFloat(GameController::Axis::TRIGGERLEFT), -1.0f);
+}
@@ -0,0 +1,104 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "gtest/gtest.h"
+
+#include "sdlwrapper/game_controller_manager.hpp"
+
+using sdlwrapper::Sdl;
+using sdlwrapper::SubsystemType;
+using sdlwrapper::GameController;
+using sdlwrapper::GameControllerManager;
+
+TEST(GameControllerManager, Open) {
+
+    Sdl<SubsystemType::GAMECONTROLLER> sdl;
+
+    GameControllerManager manager {sdl.gamecontroller()};
+    ASSERT_EQ(manager.getSize(), manager.getStates().size());
+
+    for(std::size_t i = 0; i < manager.getSize(); ++i) {
+        SDL_JoystickID id = manager.getInstanceIDs()[i];
+        EXPECT_EQ(manager.find(id), i);
+        EXPECT_EQ(manager.getController(i).getInstanceID(), id);
+        EXPECT_EQ(manager.findState(id), &manager.getStates()[i]);
+    }
+    manager.update();
+
+    EXPECT_EQ(manager.find(-1), GameControllerManager::NOT_FOUND);
+    EXPECT_EQ(manager.findState(0x7FFF), nullptr);
+}
+
+#if SDL_VERSION_ATLEAST(2, 0, 14)
+
+TEST(GameControllerManager, Hotplug) {
+
+    Sdl<SubsystemType::GAMECONTROLLER> sdl;
+
+    GameControllerManager manager {sdl.gamecontroller()};
+    std::size_t existing = manager.getSize();
+
+    // three virtual pads, added through events
+    int first = SDL_NumJoysticks();
+    std::vector<SDL_JoystickID> ids;
+    for(int i = 0; i < 3; ++i) {
+        int device = SDL_JoystickAttachVirtual(SDL_JOYSTICK_TYPE_GAMECONTROLLER, SDL_CONTROLLER_AXIS_MAX, SDL_CONTROLLER_BUTTON_MAX, 0);
+        if(device < 0) {
+            // built without virtual joysticks
+            return;
+        }
+
+        SDL_ControllerDeviceEvent event {};
+        event.type = SDL_CONTROLLERDEVICEADDED;
+        event.which = device;
+        EXPECT_TRUE(manager.handleEvent(event));
+        EXPECT_FALSE(manager.handleEvent(event));
+        ids.push_back(manager.getInstanceIDs().back());
+    }
+    ASSERT_EQ(manager.getSize(), existing + 3);
+
+    // states follow the pads
+    SDL_Joystick* joystick = SDL_JoystickOpen(first + 2);
+    ASSERT_NE(joystick, nullptr);
+    SDL_JoystickSetVirtualButton(joystick, SDL_CONTROLLER_BUTTON_A, 1);
+    SDL_JoystickSetVirtualAxis(joystick, SDL_CONTROLLER_AXIS_LEFTX, 1000);
+    SDL_GameControllerUpdate();
+    manager.update();
+    EXPECT_TRUE(manager.findState(ids[2])->wasPressed(GameController::Button::A));
+    EXPECT_EQ(manager.findState(ids[2])->get(GameController::Axis::LEFTX), 1000);
+    EXPECT_FALSE(manager.findState(ids[1])->isDown(GameController::Button::A));
+    SDL_JoystickClose(joystick);
+
+    // removing the first moves the last into its slot
+    SDL_ControllerDeviceEvent event {};
+    event.type = SDL_CONTROLLERDEVICEREMOVED;
+    event.which = ids[0];
+    EXPECT_TRUE(manager.handleEvent(event));
+    EXPECT_FALSE(manager.handleEvent(event));
+    EXPECT_EQ(manager.find(ids[0]), GameControllerManager::NOT_FOUND);
+    EXPECT_EQ(manager.find(ids[2]), existing);
+    EXPECT_TRUE(manager.findState(ids[2])->isDown(GameController::Button::A));
+    EXPECT_EQ(manager.getSize(), existing + 2);
+
+    EXPECT_TRUE(manager.close(ids[1]));
+    EXPECT_TRUE(manager.close(ids[2]));
+    EXPECT_EQ(manager.getSize(), existing);
+
+    for(int i = 2; i >= 0; --i) {
+        SDL_JoystickDetachVirtual(first + i);
+    }
+}
+
+#endif // SDL_VERSION_ATLEAST(2, 0, 14)
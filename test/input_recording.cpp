@@ -0,0 +1,123 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "gtest/gtest.h"
+
+#include "sdlwrapper/input_recording.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+using sdlwrapper::Sdl;
+using sdlwrapper::SubsystemType;
+using sdlwrapper::GameController;
+using sdlwrapper::GameControllerState;
+using sdlwrapper::InputRecorder;
+using sdlwrapper::InputPlayer;
+
+TEST(InputRecording, RoundTrip) {
+    const char* fileName = "input_recording_test.bin";
+
+    // a minute at 60 Hz, mostly idle with bursts of stick movement
+    std::vector<GameControllerState> frames(3600);
+    std::srand(7);
+    for(std::size_t i = 1; i < frames.size(); ++i) {
+        frames[i] = frames[i - 1];
+        if(i % 200 < 20) {
+            frames[i].axes[SDL_CONTROLLER_AXIS_LEFTX] = static_cast<std::int16_t>(frames[i].axes[SDL_CONTROLLER_AXIS_LEFTX] + std::rand() % 201 - 100);
+        }
+        if(i % 90 == 0) {
+            frames[i].buttons ^= GameControllerState::getMask(GameController::Button::A);
+        }
+        if(i == 1000) {
+            frames[i].axes[SDL_CONTROLLER_AXIS_TRIGGERRIGHT] = 32767;
+            frames[i].axes[SDL_CONTROLLER_AXIS_RIGHTY] = -32768;
+        }
+        // buttons past the 16th, like the paddles and touchpad of newer SDL versions
+        if(i == 2000 || i == 2001) {
+            frames[i].buttons ^= 1u << 20;
+        }
+    }
+
+    {
+        InputRecorder recorder {fileName};
+        for(const GameControllerState& state : frames) {
+            recorder.record(state);
+        }
+        recorder.flush();
+        EXPECT_EQ(recorder.getFrames(), frames.size());
+
+        // 360 moving frames at about 3 bytes, the rest mostly in runs
+        EXPECT_LT(recorder.getSizeBytes(), 1600u);
+    }
+
+    InputPlayer player {fileName};
+    GameControllerState state;
+    for(std::size_t i = 0; i < frames.size(); ++i) {
+        ASSERT_TRUE(player.next(state));
+        ASSERT_EQ(state.buttons, frames[i].buttons) << i;
+        ASSERT_EQ(state.axes, frames[i].axes) << i;
+    }
+    EXPECT_FALSE(player.next(state));
+    EXPECT_EQ(player.getFrame(), frames.size());
+
+    // edges are recomputed on playback
+    player.rewind();
+    for(std::size_t i = 0; i < 90; ++i) {
+        player.next(state);
+    }
+    EXPECT_FALSE(state.wasPressed(GameController::Button::A));
+    player.next(state);
+    EXPECT_TRUE(state.wasPressed(GameController::Button::A));
+
+    std::remove(fileName);
+}
+
+#if SDL_VERSION_ATLEAST(2, 0, 14)
+
+using sdlwrapper::SdlError;
+using sdlwrapper::VirtualGameController;
+
+TEST(InputRecording, VirtualGameController) {
+    Sdl<SubsystemType::GAMECONTROLLER> sdl;
+
+    std::unique_ptr<VirtualGameController> virtualController;
+    try {
+        virtualController = std::make_unique<VirtualGameController>(sdl.gamecontroller());
+    }
+    catch(const SdlError&) {
+        // built without virtual joysticks
+        return;
+    }
+
+    GameController controller {sdl.gamecontroller(), virtualController->getDeviceIndex()};
+    EXPECT_EQ(controller.getInstanceID(), virtualController->getInstanceID());
+
+    GameControllerState replayed;
+    replayed.buttons = GameControllerState::getMask(GameController::Button::X) | GameControllerState::getMask(GameController::Button::DPAD_LEFT);
+    replayed.axes = {-32768, 12345, 0, 32767, 16000, 32767};
+    virtualController->apply(replayed);
+    SDL_GameControllerUpdate();
+
+    GameControllerState state = controller.snapshot();
+    EXPECT_EQ(state.buttons, replayed.buttons);
+    for(GameController::Axis axis : GameController::ALL_AXES) {
+        EXPECT_NEAR(state.get(axis), replayed.get(axis), 1);
+    }
+}
+
+#endif // SDL_VERSION_ATLEAST(2, 0, 14)
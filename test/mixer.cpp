@@ -0,0 +1,216 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "gtest/gtest.h"
+
+#include "sdlwrapper/mixer.hpp"
+
+#include <thread>
+#include <vector>
+
+using sdlwrapper::Sdl;
+using sdlwrapper::SubsystemType;
+using sdlwrapper::AudioDevice;
+using sdlwrapper::Mixer;
+
+TEST(Mixer, MixVoices) {
+    Mixer mixer {2};
+
+    std::vector<float> mono(300, 0.5f);
+    std::vector<float> stereo(20, 0.25f);
+
+    Mixer::VoiceId first = mixer.play(mono.data(), 300, 1, 1.0f, -1.0f);
+    Mixer::VoiceId second = mixer.play(stereo.data(), 10, 2, 2.0f);
+    EXPECT_NE(first, Mixer::INVALID_VOICE);
+    EXPECT_NE(second, Mixer::INVALID_VOICE);
+
+    // no free voices
+    EXPECT_EQ(mixer.play(mono.data(), 300, 1), Mixer::INVALID_VOICE);
+    EXPECT_FALSE(mixer.stop(mixer.play(mono.data(), 300, 1)));
+    EXPECT_FALSE(mixer.setGain(Mixer::INVALID_VOICE, 0.0f));
+
+    // ids from outside the voice table are ignored on the audio thread
+    EXPECT_TRUE(mixer.stop(0x1FFFE));
+
+    std::vector<float> out(2 * 300);
+    mixer.mix(out.data(), 20);
+    EXPECT_EQ(mixer.getActiveVoices(), 1u);
+
+    EXPECT_NEAR(out[0], 1.0f, 1e-6f);
+    EXPECT_NEAR(out[1], 0.5f, 1e-6f);
+    EXPECT_NEAR(out[2 * 10], 0.5f, 1e-6f);
+    EXPECT_NEAR(out[2 * 10 + 1], 0.0f, 1e-6f);
+
+    // the second voice finished, so its slot is reused
+    Mixer::VoiceId third = mixer.play(stereo.data(), 10, 2);
+    EXPECT_NE(third, Mixer::INVALID_VOICE);
+    EXPECT_NE(third, second);
+
+    // stale ids are ignored
+    EXPECT_TRUE(mixer.stop(second));
+    EXPECT_TRUE(mixer.stop(first));
+    mixer.mix(out.data(), 4);
+    EXPECT_EQ(mixer.getActiveVoices(), 1u);
+    EXPECT_NEAR(out[0], 0.25f, 1e-6f);
+
+    EXPECT_TRUE(mixer.stopAll());
+    mixer.mix(out.data(), 4);
+    EXPECT_EQ(mixer.getActiveVoices(), 0u);
+    EXPECT_EQ(out[0], 0.0f);
+}
+
+TEST(Mixer, LoopAndClip) {
+    Mixer mixer;
+
+    std::vector<float> mono(7, 1.0f);
+    Mixer::VoiceId voice = mixer.play(mono.data(), 7, 1, 4.0f, 0.0f, true);
+
+    std::vector<float> out(2 * 1000);
+    mixer.mix(out.data(), 1000);
+    EXPECT_EQ(mixer.getActiveVoices(), 1u);
+    for(float sample : out) {
+        EXPECT_EQ(sample, 1.0f);
+    }
+
+    EXPECT_TRUE(mixer.setGain(voice, 0.5f, 1.0f));
+    mixer.mix(out.data(), 1);
+    EXPECT_NEAR(out[0], 0.0f, 1e-6f);
+    EXPECT_NEAR(out[1], 0.5f, 1e-6f);
+}
+
+TEST(Mixer, Schedule) {
+    Mixer mixer;
+
+    std::vector<float> mono(1000, 1.0f);
+    std::vector<float> out(2 * 512);
+
+    // lands mid-buffer, and mid-block on the second mix
+    Mixer::VoiceId voice = mixer.play(mono.data(), 1000, 1, 1.0f, -1.0f, false, 300);
+    EXPECT_TRUE(mixer.stop(voice, 700));
+
+    mixer.mix(out.data(), 512);
+    EXPECT_EQ(mixer.getFramePosition(), 512u);
+    EXPECT_EQ(mixer.getActiveVoices(), 1u);
+    EXPECT_FLOAT_EQ(out[2 * 299], 0.0f);
+    EXPECT_FLOAT_EQ(out[2 * 300], 1.0f);
+    EXPECT_FLOAT_EQ(out[2 * 511], 1.0f);
+
+    mixer.mix(out.data(), 512);
+    EXPECT_EQ(mixer.getActiveVoices(), 0u);
+    EXPECT_FLOAT_EQ(out[2 * (699 - 512)], 1.0f);
+    EXPECT_FLOAT_EQ(out[2 * (700 - 512)], 0.0f);
+
+    // past frames mean the next mix
+    mixer.play(mono.data(), 1000, 1, 1.0f, -1.0f, false, 1);
+    mixer.mix(out.data(), 1);
+    EXPECT_FLOAT_EQ(out[0], 1.0f);
+}
+
+TEST(Mixer, CancelScheduled) {
+    Mixer mixer {1};
+
+    std::vector<float> mono(16, 1.0f);
+    std::vector<float> out(2 * 512);
+
+    // stopped before it starts, so it never does
+    Mixer::VoiceId voice = mixer.play(mono.data(), 16, 1, 1.0f, 0.0f, true, 1000);
+    EXPECT_TRUE(mixer.stop(voice));
+    mixer.mix(out.data(), 512);
+    mixer.mix(out.data(), 512);
+    EXPECT_EQ(mixer.getActiveVoices(), 0u);
+    EXPECT_FLOAT_EQ(out[2 * (1000 - 512)], 0.0f);
+
+    // and its slot is free again
+    voice = mixer.play(mono.data(), 16, 1, 1.0f, 0.0f, false, mixer.getFramePosition() + 100);
+    ASSERT_NE(voice, Mixer::INVALID_VOICE);
+
+    // changed before it starts
+    EXPECT_TRUE(mixer.setGain(voice, 0.5f, -1.0f));
+    mixer.mix(out.data(), 101);
+    EXPECT_EQ(mixer.getActiveVoices(), 1u);
+    EXPECT_FLOAT_EQ(out[2 * 100], 0.5f);
+    EXPECT_FLOAT_EQ(out[2 * 100 + 1], 0.0f);
+
+    // stopAll cancels looping voices waiting to start, and frees their slots
+    mixer.stopAll();
+    mixer.mix(out.data(), 1);
+    voice = mixer.play(mono.data(), 16, 1, 1.0f, 0.0f, true, mixer.getFramePosition() + 100);
+    ASSERT_NE(voice, Mixer::INVALID_VOICE);
+    EXPECT_TRUE(mixer.stopAll());
+    mixer.mix(out.data(), 512);
+    EXPECT_EQ(mixer.getActiveVoices(), 0u);
+    EXPECT_FLOAT_EQ(out[2 * 100], 0.0f);
+    EXPECT_NE(mixer.play(mono.data(), 16, 1), Mixer::INVALID_VOICE);
+}
+
+TEST(Mixer, PastFramesKeepOrder) {
+    Mixer mixer;
+
+    std::vector<float> mono(1000, 1.0f);
+    std::vector<float> out(2 * 64);
+
+    Mixer::VoiceId voice = mixer.play(mono.data(), 1000, 1, 1.0f, -1.0f);
+    mixer.mix(out.data(), 64);
+
+    // an already mixed frame and NOW both mean the next mix, so the later command wins
+    EXPECT_TRUE(mixer.setGain(voice, 0.2f, -1.0f, 10));
+    EXPECT_TRUE(mixer.setGain(voice, 0.8f, -1.0f));
+    mixer.mix(out.data(), 1);
+    EXPECT_FLOAT_EQ(out[0], 0.8f);
+}
+
+TEST(Mixer, Threads) {
+    Mixer mixer {64};
+
+    std::vector<float> mono(16, 0.5f);
+    std::vector<float> out(2 * 64);
+
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 4; ++t) {
+        threads.emplace_back([&]() {
+            for(int i = 0; i < 1000; ++i) {
+                Mixer::VoiceId voice = mixer.play(mono.data(), 16, 1);
+                if(voice != Mixer::INVALID_VOICE && i % 2 == 0) {
+                    mixer.stop(voice);
+                }
+            }
+        });
+    }
+
+    for(int i = 0; i < 2000; ++i) {
+        mixer.mix(out.data(), 64);
+    }
+    for(std::thread& thread : threads) {
+        thread.join();
+    }
+
+    // voices finish within a mix, so every slot comes back
+    mixer.mix(out.data(), 64);
+    mixer.mix(out.data(), 64);
+    EXPECT_EQ(mixer.getActiveVoices(), 0u);
+    std::size_t played = 0;
+    while(mixer.play(mono.data(), 16, 1) != Mixer::INVALID_VOICE) {
+        ++played;
+    }
+    EXPECT_EQ(played, 64u);
+}
+
+TEST(Mixer, AudioDevice) {
+    Sdl<SubsystemType::AUDIO> sdl;
+
+    Mixer mixer;
+
+    AudioDevice device {sdl.audio(), nullptr, false, 48000, AUDIO_F32SYS, 2, 1024, Mixer::callback, &mixer};
+}
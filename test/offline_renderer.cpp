@@ -0,0 +1,136 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "gtest/gtest.h"
+
+#include "sdlwrapper/mixer.hpp"
+#include "sdlwrapper/offline_renderer.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+using sdlwrapper::Mixer;
+using sdlwrapper::OfflineRenderer;
+
+namespace
+{
+
+SDL_AudioSpec makeSpec()
+{
+    SDL_AudioSpec spec {};
+    spec.freq = 48000;
+    spec.format = AUDIO_F32SYS;
+    spec.channels = 2;
+    spec.samples = 1000;
+    return spec;
+}
+
+// renders 8 mixers of 4 voices each, with a fresh set of mixers every call
+std::vector<float> renderMixers(std::size_t threads, std::size_t frames)
+{
+    std::vector<float> tone(4800);
+    for(std::size_t i = 0; i < tone.size(); ++i) {
+        tone[i] = 0.1f * std::sin(i * 0.05f);
+    }
+
+    OfflineRenderer renderer {makeSpec(), threads};
+    std::vector<std::unique_ptr<Mixer>> mixers;
+    for(int track = 0; track < 8; ++track) {
+        mixers.push_back(std::make_unique<Mixer>(4));
+        for(int voice = 0; voice < 4; ++voice) {
+            mixers.back()->play(tone.data() + track * 7 + voice, 4000, 1, 0.3f + voice * 0.1f, track / 4.0f - 1.0f, true);
+        }
+        renderer.addTrack(Mixer::callback, mixers.back().get());
+    }
+
+    std::vector<float> out(frames * 2);
+    renderer.render(out.data(), frames);
+    return out;
+}
+
+} // namespace
+
+TEST(OfflineRenderer, Deterministic) {
+    const std::size_t frames = 48000;
+    std::vector<float> single = renderMixers(1, frames);
+    std::vector<float> many = renderMixers(7, frames);
+    EXPECT_EQ(single, many);
+
+    // tracks are summed, not mixed over each other
+    float peak = 0.0f;
+    for(float sample : single) {
+        peak = std::max(peak, std::abs(sample));
+    }
+    EXPECT_GT(peak, 0.5f);
+}
+
+TEST(OfflineRenderer, Wav) {
+    struct Ramp
+    {
+        float next = 0.0f;
+        int calls = 0;
+        int shortCalls = 0;
+    };
+    Ramp ramp;
+
+    OfflineRenderer renderer {makeSpec(), 2};
+    renderer.addTrack([](void* userdata, std::uint8_t* stream, int len) {
+        Ramp* ramp = reinterpret_cast<Ramp*>(userdata);
+        float* samples = reinterpret_cast<float*>(stream);
+        for(std::size_t i = 0; i < len / sizeof(float); ++i) {
+            samples[i] = ramp->next;
+            ramp->next += 1e-5f;
+        }
+        ++ramp->calls;
+        if(len != 1000 * 2 * sizeof(float)) {
+            ++ramp->shortCalls;
+        }
+    }, &ramp);
+
+    const char* fileName = "offline_renderer_test.wav";
+    renderer.renderToWav(fileName, 20500);
+    // called like a device, 1000 frames at a time, with the last 500 frames kept for the next render
+    EXPECT_EQ(ramp.calls, 21);
+    EXPECT_EQ(ramp.shortCalls, 0);
+
+    SDL_RWops* rw = SDL_RWFromFile(fileName, "rb");
+    ASSERT_NE(rw, nullptr);
+    sdlwrapper::detail::WavHeader header = sdlwrapper::detail::readWavHeader(rw);
+    EXPECT_EQ(header.freq, 48000);
+    EXPECT_EQ(header.format, AUDIO_F32LSB);
+    EXPECT_EQ(header.channels, 2);
+    EXPECT_EQ(header.dataSize, 20500u * 2 * sizeof(float));
+
+    std::vector<float> samples(20500 * 2);
+    EXPECT_EQ(SDL_RWread(rw, samples.data(), sizeof(float), samples.size()), samples.size());
+    SDL_RWclose(rw);
+    std::remove(fileName);
+
+    EXPECT_FLOAT_EQ(samples[0], 0.0f);
+    EXPECT_FLOAT_EQ(samples[1], 1e-5f);
+
+    // continues from the kept frames without another callback, then calls again
+    std::vector<float> next(1000 * 2);
+    renderer.render(next.data(), 500);
+    EXPECT_EQ(ramp.calls, 21);
+    EXPECT_EQ(next[0], samples.back() + 1e-5f);
+    EXPECT_EQ(next[2 * 500 - 1], ramp.next - 1e-5f);
+
+    renderer.render(next.data(), 1000);
+    EXPECT_EQ(ramp.calls, 22);
+    EXPECT_EQ(ramp.shortCalls, 0);
+}
@@ -0,0 +1,92 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "gtest/gtest.h"
+
+#include "sdlwrapper/queue_streamer.hpp"
+
+#include <atomic>
+#include <cstring>
+
+using sdlwrapper::Sdl;
+using sdlwrapper::SubsystemType;
+using sdlwrapper::AudioDevice;
+
+#ifdef SDLWRAPPER_AUDIO_SUPPORTS_NONCALLBACK
+
+using sdlwrapper::QueueStreamer;
+
+TEST(QueueStreamer, Watermarks) {
+    Sdl<SubsystemType::AUDIO> sdl;
+
+    AudioDevice device {sdl.audio(), nullptr, false, 48000, AUDIO_S16SYS, 2, 256};
+
+    std::atomic<std::uint64_t> produced {0};
+    auto source = [&](std::uint8_t* data, std::uint32_t len) {
+        std::memset(data, 0, len);
+        produced += len;
+        return len;
+    };
+
+    {
+        QueueStreamer streamer {device, source, 20, 40};
+
+        // primes the queue to the high watermark before playing
+        for(int i = 0; i < 100 && streamer.getBatchSize() == 0; ++i) {
+            SDL_Delay(1);
+        }
+        SDL_Delay(5);
+        EXPECT_EQ(device.getQueueSize(), 48000u * 4 * 40 / 1000);
+
+        device.play();
+        SDL_Delay(200);
+        device.pause();
+
+        // 40 ms primed, plus roughly 200 ms drained
+        EXPECT_GT(produced, 48000u * 4 * 150 / 1000);
+        EXPECT_LE(streamer.getLatency(), 40000u);
+        EXPECT_EQ(streamer.getUnderruns(), 0u);
+        EXPECT_GT(streamer.getDrainRate(), 0.0);
+    }
+}
+
+TEST(QueueStreamer, QueueError) {
+    Sdl<SubsystemType::AUDIO> sdl;
+
+    // SDL refuses to queue to a device with a callback
+    SDL_AudioCallback callback = [](void*, std::uint8_t* stream, int len) {
+        std::memset(stream, 0, len);
+    };
+    AudioDevice device {sdl.audio(), nullptr, false, 48000, AUDIO_S16SYS, 2, 256, callback};
+
+    std::atomic<int> calls {0};
+    auto source = [&](std::uint8_t* data, std::uint32_t len) {
+        std::memset(data, 0, len);
+        ++calls;
+        return len;
+    };
+
+    QueueStreamer streamer {device, source, 20, 40};
+    for(int i = 0; i < 100 && streamer.getErrors() < 2; ++i) {
+        SDL_Delay(1);
+    }
+    EXPECT_GE(streamer.getErrors(), 2u);
+    EXPECT_FALSE(streamer.getLastError().empty());
+
+    // the failed batch is retried, not produced again
+    EXPECT_EQ(calls, 1);
+}
+
+#endif // SDLWRAPPER_AUDIO_SUPPORTS_NONCALLBACK
@@ -0,0 +1,105 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "gtest/gtest.h"
+
+#include "sdlwrapper/resampler.hpp"
+
+#include <cmath>
+#include <vector>
+
+using sdlwrapper::Resampler;
+using sdlwrapper::ResamplerQuality;
+
+namespace
+{
+
+std::vector<float> sine(int freq, float hz, std::size_t frames)
+{
+    std::vector<float> result(frames);
+    for(std::size_t i = 0; i < frames; ++i) {
+        result[i] = static_cast<float>(std::sin(2.0 * M_PI * hz * i / freq));
+    }
+    return result;
+}
+
+} // namespace
+
+TEST(Resampler, Linear) {
+    Resampler resampler {1, 2, 1, ResamplerQuality::LINEAR};
+
+    float in[4] {0.0f, 1.0f, 2.0f, 3.0f};
+    float out[8] {};
+    Resampler::Result result = resampler.process(in, 4, out, 8);
+    EXPECT_EQ(result.inputFrames, 4u);
+    EXPECT_EQ(result.outputFrames, 6u);
+    EXPECT_FLOAT_EQ(out[0], 0.0f);
+    EXPECT_FLOAT_EQ(out[1], 0.5f);
+    EXPECT_FLOAT_EQ(out[2], 1.0f);
+    EXPECT_FLOAT_EQ(out[5], 2.5f);
+}
+
+TEST(Resampler, Streaming) {
+    const int srcFreq = 44100;
+    const int dstFreq = 48000;
+    std::vector<float> in = sine(srcFreq, 1000.0f, srcFreq / 10);
+
+    // feed in small uneven pieces, to a small output buffer
+    Resampler resampler {srcFreq, dstFreq, 1, ResamplerQuality::SINC_HIGH};
+    std::vector<float> out;
+    std::size_t offset = 0;
+    while(offset < in.size()) {
+        float buf[37];
+        Resampler::Result result = resampler.process(in.data() + offset, std::min<std::size_t>(101, in.size() - offset), buf, 37);
+        offset += result.inputFrames;
+        out.insert(out.end(), buf, buf + result.outputFrames);
+    }
+
+    EXPECT_NEAR(static_cast<double>(out.size()), static_cast<double>(in.size() - resampler.getLatency()) * dstFreq / srcFreq, 2.0);
+    EXPECT_LE(out.size(), resampler.getMaxOutputFrames(in.size()));
+
+    // compare the steady state against an ideal sine at the new rate
+    std::vector<float> expected = sine(dstFreq, 1000.0f, out.size());
+    for(std::size_t i = 100; i < out.size(); ++i) {
+        EXPECT_NEAR(out[i], expected[i], 2e-3f);
+    }
+}
+
+TEST(Resampler, Downsample) {
+    const int srcFreq = 96000;
+    const int dstFreq = 48000;
+
+    for(ResamplerQuality quality : {ResamplerQuality::SINC_MEDIUM, ResamplerQuality::SINC_HIGH}) {
+        // stereo, left is audible, right is above the new nyquist frequency
+        std::vector<float> left = sine(srcFreq, 440.0f, 9600);
+        std::vector<float> right = sine(srcFreq, 30000.0f, 9600);
+        std::vector<float> in(9600 * 2);
+        for(std::size_t i = 0; i < left.size(); ++i) {
+            in[i * 2] = left[i];
+            in[i * 2 + 1] = right[i];
+        }
+
+        Resampler resampler {srcFreq, dstFreq, 2, quality};
+        std::vector<float> out(resampler.getMaxOutputFrames(9600) * 2);
+        Resampler::Result result = resampler.process(in.data(), 9600, out.data(), out.size() / 2);
+        EXPECT_EQ(result.inputFrames, 9600u);
+
+        std::vector<float> expected = sine(dstFreq, 440.0f, result.outputFrames);
+        for(std::size_t i = 100; i < result.outputFrames; ++i) {
+            EXPECT_NEAR(out[i * 2], expected[i], 5e-3f);
+            EXPECT_NEAR(out[i * 2 + 1], 0.0f, quality == ResamplerQuality::SINC_HIGH ? 0.005f : 0.1f);
+        }
+    }
+}
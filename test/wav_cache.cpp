@@ -0,0 +1,75 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "gtest/gtest.h"
+
+#include "sdlwrapper/wav_cache.hpp"
+
+using sdlwrapper::Sdl;
+using sdlwrapper::SubsystemType;
+using sdlwrapper::Wav;
+using sdlwrapper::WavCache;
+
+TEST(WavCache, Load) {
+    Sdl<SubsystemType::AUDIO> sdl;
+
+    const char* fileName = SDLWRAPPER_TEST_RES_DIR "/para_open-01.wav";
+    Wav wav {sdl.audio(), fileName};
+
+    SDL_AudioSpec native {};
+    native.freq = wav.getFreq();
+    native.format = wav.getAudioFormat();
+    native.channels = wav.getChannels();
+
+    SDL_AudioSpec device = native;
+    device.format = AUDIO_S16SYS;
+    device.channels = 1;
+
+    WavCache cache {sdl.audio(), 64 * 1024 * 1024};
+
+    WavCache::Handle first = cache.load(fileName, native);
+    ASSERT_TRUE(first);
+    EXPECT_EQ(first->getSizeBytes(), wav.getSizeBytes());
+    EXPECT_TRUE(std::equal(first->begin(), first->end(), wav.begin()));
+
+    // same key shares the samples
+    EXPECT_EQ(cache.load(fileName, native), first);
+
+    WavCache::Handle converted = cache.load(fileName, device);
+    EXPECT_NE(converted, first);
+    EXPECT_EQ(converted->getAudioFormat(), AUDIO_S16SYS);
+    EXPECT_EQ(converted->getChannels(), 1);
+
+    WavCache::Stats stats = cache.getStats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 2u);
+    EXPECT_EQ(stats.evictions, 0u);
+    EXPECT_EQ(stats.entries, 2u);
+    EXPECT_EQ(stats.sizeBytes, first->getSizeBytes() + converted->getSizeBytes());
+
+    // touch native, so converted is least recently used
+    cache.load(fileName, native);
+    cache.setBudget(first->getSizeBytes());
+    stats = cache.getStats();
+    EXPECT_EQ(stats.evictions, 1u);
+    EXPECT_EQ(stats.entries, 1u);
+    EXPECT_EQ(cache.load(fileName, native), first);
+
+    // evicted assets stay valid while handles remain
+    EXPECT_EQ(converted->getChannels(), 1);
+    EXPECT_NE(cache.load(fileName, device), converted);
+
+    EXPECT_THROW(cache.load("does_not_exist.wav", native), sdlwrapper::SdlError);
+}
@@ -0,0 +1,84 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "gtest/gtest.h"
+
+#include "sdlwrapper/wav_loader.hpp"
+
+#include <future>
+#include <string>
+#include <vector>
+
+using sdlwrapper::Sdl;
+using sdlwrapper::SubsystemType;
+using sdlwrapper::Wav;
+using sdlwrapper::WavBatch;
+using sdlwrapper::WavBatchResult;
+using sdlwrapper::WavLoader;
+
+TEST(WavLoader, Futures) {
+    Sdl<SubsystemType::AUDIO> sdl;
+
+    const char* fileName = SDLWRAPPER_TEST_RES_DIR "/para_open-01.wav";
+    Wav wav {sdl.audio(), fileName};
+
+    WavLoader loader {sdl.audio(), 2};
+    WavBatch batch = loader.load({"does_not_exist.wav", fileName, fileName});
+    ASSERT_EQ(batch.assets.size(), 3u);
+
+    // results keep the order given, not the order loaded
+    EXPECT_THROW(batch.assets[0].get(), sdlwrapper::SdlError);
+    std::shared_ptr<const sdlwrapper::AudioAsset> asset = batch.assets[1].get();
+    ASSERT_TRUE(asset);
+    EXPECT_EQ(asset->getAudioFormat(), wav.getAudioFormat());
+    EXPECT_EQ(asset->getSizeBytes(), wav.getSizeBytes());
+    EXPECT_TRUE(std::equal(asset->begin(), asset->end(), wav.begin()));
+    EXPECT_NE(batch.assets[2].get(), asset);
+
+    EXPECT_GE(batch.wallTime.get().count(), 0);
+
+    // empty batches finish immediately
+    WavBatch empty = loader.load({});
+    EXPECT_TRUE(empty.assets.empty());
+    EXPECT_EQ(empty.wallTime.get().count(), 0);
+}
+
+TEST(WavLoader, Completion) {
+    Sdl<SubsystemType::AUDIO> sdl;
+
+    SDL_AudioSpec spec {};
+    spec.freq = 22050;
+    spec.format = AUDIO_S16SYS;
+    spec.channels = 1;
+
+    std::vector<std::string> fileNames {SDLWRAPPER_TEST_RES_DIR "/para_open-01.wav", "does_not_exist.wav"};
+
+    std::promise<WavBatchResult> promise;
+    WavLoader loader {sdl.audio()};
+    loader.load(fileNames, &spec, [&](WavBatchResult result) {
+        promise.set_value(std::move(result));
+    });
+    WavBatchResult result = promise.get_future().get();
+
+    ASSERT_EQ(result.assets.size(), 2u);
+    ASSERT_TRUE(result.assets[0]);
+    EXPECT_EQ(result.assets[0]->getFreq(), 22050);
+    EXPECT_EQ(result.assets[0]->getAudioFormat(), AUDIO_S16SYS);
+    EXPECT_EQ(result.assets[0]->getChannels(), 1);
+    EXPECT_TRUE(result.errors[0].empty());
+
+    EXPECT_FALSE(result.assets[1]);
+    EXPECT_FALSE(result.errors[1].empty());
+}
@@ -0,0 +1,72 @@
+/*
+   Copyright 2017 Cory Sherman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "gtest/gtest.h"
+
+#include "sdlwrapper/wav_stream.hpp"
+
+#include <algorithm>
+#include <vector>
+
+using sdlwrapper::Sdl;
+using sdlwrapper::SubsystemType;
+using sdlwrapper::SdlError;
+using sdlwrapper::Wav;
+using sdlwrapper::WavStream;
+
+TEST(WavStream, MatchesWav) {
+    Sdl<SubsystemType::AUDIO> sdl;
+
+    Wav wav { sdl.audio(), SDLWRAPPER_TEST_RES_DIR "/para_open-01.wav" };
+    WavStream stream { sdl.audio(), SDLWRAPPER_TEST_RES_DIR "/para_open-01.wav", false, 4096 };
+
+    EXPECT_EQ(stream.getAudioFormat(), wav.getAudioFormat());
+    EXPECT_EQ(stream.getChannels(), wav.getChannels());
+    EXPECT_EQ(stream.getFreq(), wav.getFreq());
+    EXPECT_EQ(stream.getSizeBytes(), wav.getSizeBytes());
+
+    std::vector<std::uint8_t> data;
+    std::uint8_t buf[3000];
+    while(!stream.isFinished()) {
+        std::uint32_t numRead = stream.read(buf, sizeof(buf));
+        data.insert(data.end(), buf, buf + numRead);
+        if(numRead == 0) {
+            SDL_Delay(1);
+        }
+    }
+
+    ASSERT_EQ(data.size(), wav.getSizeBytes());
+    EXPECT_TRUE(std::equal(data.begin(), data.end(), wav.begin()));
+}
+
+TEST(WavStream, Loop) {
+    Sdl<SubsystemType::AUDIO> sdl;
+
+    WavStream stream { sdl.audio(), SDLWRAPPER_TEST_RES_DIR "/para_open-01.wav", true, 4096 };
+
+    std::vector<std::uint8_t> buf(stream.getSizeBytes() + 1000);
+    std::uint32_t total = 0;
+    while(total < buf.size()) {
+        total += stream.read(buf.data() + total, static_cast<std::uint32_t>(buf.size() - total));
+    }
+    EXPECT_FALSE(stream.isFinished());
+    EXPECT_TRUE(std::equal(buf.begin() + stream.getSizeBytes(), buf.end(), buf.begin()));
+}
+
+TEST(WavStream, MissingFile) {
+    Sdl<SubsystemType::AUDIO> sdl;
+
+    EXPECT_THROW((WavStream { sdl.audio(), SDLWRAPPER_TEST_RES_DIR "/missing.wav" }), SdlError);
+}